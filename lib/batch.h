@@ -0,0 +1,54 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct ROM ROM;
+
+/*
+    MANIFEST FORMAT
+    One job per line: <rom.nes> <movie.fm2 | -> <frames>
+    '-' runs the job with no input, lines starting with '#' are comments
+*/
+
+#define MANIFEST_LINE_LENGTH 1024
+
+typedef struct BatchJob {
+    char *rom_path;
+    char *movie_path; // NULL if the job has no input
+    int frames;
+    ROM *rom; // Shared by every job on the same file, NULL until batch_run() or if it couldn't be loaded
+} BatchJob;
+
+typedef struct BatchResult {
+    bool success; // The ROM and movie could be loaded
+    bool stopped; // The program stopped before running every frame
+    int frames;
+    int worker;
+    double seconds;
+    uint64_t ram_hash;
+    uint64_t frame_hash; // Only the last frame is drawn, so jobs that stopped early hash an older one
+} BatchResult;
+
+typedef struct BatchWorkerStats {
+    int jobs;
+    long frames;
+    double seconds; // Time spent running jobs
+} BatchWorkerStats;
+
+typedef struct Batch {
+    BatchJob *jobs;
+    BatchResult *results; // One per job, in manifest order
+    int job_count;
+    BatchWorkerStats *workers;
+    int worker_count;
+    double seconds; // Wall time of the whole batch
+} Batch;
+
+Batch *batch_load_manifest(const char *file_path);
+void batch_destroy(Batch *batch);
+int batch_default_workers(void);
+bool batch_run(Batch *batch, int worker_count);
+
+#endif
@@ -1,7 +1,13 @@
 #ifndef BUS_H
 #define BUS_H
 
+#include "diagnostics.h"
+#include "joypad.h"
+#include "mapper.h"
+
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 #define RAM_START 0x0000
 #define RAM_MIRROR_END 0x1FFF
@@ -12,14 +18,31 @@
 #define PRG_ROM_START 0x8000
 #define PRG_ROM_MIRROR_END 0xFFFF
 
+// The CPU address space is split into 256 pages of 256 bytes each
+#define BUS_PAGE_SIZE 0x100
+#define BUS_PAGE_COUNT 0x100
+
+// CPU cycles stalled by an OAM DMA, one more if it starts on an odd cycle
+#define OAM_DMA_CYCLES 513
+
 typedef struct ROM ROM;
 typedef struct PPU PPU;
 
 typedef struct Bus {
     uint8_t ram[0x0800];
+    // Direct pointers to the memory behind each page
+    // NULL means the page is handled by the I/O fallback
+    uint8_t *read_pages[BUS_PAGE_COUNT];
+    uint8_t *write_pages[BUS_PAGE_COUNT];
     ROM *rom;
     PPU *ppu;
-    int cycles;
+    // CPU cycles run since power-up, counted by the instructions as they run
+    // bus_tick() catches the PPU up with them, it doesn't count them again
+    uint64_t cycles;
+    Joypad joypad_1; // 0x4016
+    Joypad joypad_2; // 0x4017
+    Diagnostics diagnostics;
+    Mapper mapper;
 } Bus;
 
 typedef enum Interrupt {
@@ -30,10 +53,15 @@ typedef enum Interrupt {
 
 
 Bus *new_bus(ROM *rom);
+void bus_create(Bus *bus, PPU *ppu, uint8_t *cart_memory, size_t cart_memory_size, ROM *rom);
+void bus_load_rom(Bus *bus, ROM *rom);
+void bus_map_memory(Bus *bus, uint16_t addr, int size, uint8_t *memory, bool writable);
 Interrupt bus_tick(Bus *bus, int cycles);
 uint8_t bus_mem_read(Bus *bus, uint16_t addr);
 void bus_mem_write(Bus *bus, uint8_t value, uint16_t addr);
+void bus_oam_dma(Bus *bus, uint8_t page);
 Interrupt bus_poll_for_interrupt(Bus *bus);
 void bus_clear_interrupt(Bus *bus);
+bool bus_poll_for_frame(Bus *bus);
 
 #endif
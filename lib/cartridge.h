@@ -3,8 +3,11 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
 
 // Header defines
+#define HEADER_LENGTH 16
 #define TAG_LENGTH 4
 #define PRG_ROM_LENGTH_ADDR 4
 #define CHR_ROM_LENGTH_ADDR 5
@@ -12,6 +15,26 @@
 #define CONTROL_BYTE_2_ADDR 7
 #define PRG_RAM_LENGTH_ADDR 8
 
+/*
+    NES 2.0 HEADER
+    Marked by bits 2-3 of byte 7 being 0b10, bytes 8-15 are then
+
+    8:  SSSS MMMM  Submapper, bits 8-11 of the mapper number
+    9:  CCCC PPPP  Bits 8-11 of the CHR and PRG ROM sizes
+                   0xF means the size byte is EEEEEEMM instead, 2^E * (MM * 2 + 1) bytes
+    10: NNNN RRRR  PRG NVRAM and PRG RAM sizes, 64 << shift bytes or none if 0
+    11: NNNN RRRR  CHR NVRAM and CHR RAM sizes, the same way
+    12: .... ..TT  Timing (0: NTSC; 1: PAL; 2: either; 3: Dendy)
+*/
+
+#define FORMAT_BITS 0b00001100
+#define NES2_FORMAT 0b00001000
+#define MAPPER_MSB_ADDR 8
+#define ROM_SIZE_MSB_ADDR 9
+#define PRG_RAM_SHIFT_ADDR 10
+#define CHR_RAM_SHIFT_ADDR 11
+#define TIMING_ADDR 12
+
 #define TRAINER_LENGTH 512
 
 // PRG and CHR ROM length are informed by a single byte each in the header
@@ -19,26 +42,60 @@
 // 16 kB for PRG and 8 kB for CHR
 #define PRG_ROM_PAGE_SIZE 16384
 #define CHR_ROM_PAGE_SIZE 8192
+// iNES 1.0 gives PRG RAM in units of 8 kB as well, 0 meaning a single unit
+#define PRG_RAM_PAGE_SIZE 8192
+// iNES 1.0 carts without CHR ROM have this much CHR RAM
+#define CHR_RAM_DEFAULT_SIZE 8192
 
 
 typedef enum Mirroring {
     Vertical,
     Horizontal,
     FourScreen,
+    // Only set by mappers
+    SingleScreenLower,
+    SingleScreenUpper,
 } Mirroring;
 
+typedef enum Timing {
+    NTSC,
+    PAL,
+    MultiRegion,
+    Dendy,
+} Timing;
+
+// ROMs loaded by get_rom() point into a read-only mapping of the file, so every console running the same
+// ROM shares its memory. Anything a console writes to, like CHR RAM, belongs to its mapper instead
+// Windows builds read the file into memory instead of mapping it, consoles still share that copy
 typedef struct ROM {
     uint8_t *prg_rom;
-    uint8_t *chr_rom;
+    uint8_t *chr_rom; // NULL if the cart has CHR RAM
     int prg_rom_length;
     int chr_rom_length;
-    uint8_t mapper;
+    uint16_t mapper;
+    uint8_t submapper; // NES 2.0 only
     Mirroring mirroring;
+    // Cart RAM, NVRAM is the part kept by the battery
+    int prg_ram_length;
+    int prg_nvram_length;
+    int chr_ram_length;
+    int chr_nvram_length;
+    bool battery;
+    Timing timing;
+    bool nes2; // The header is in the NES 2.0 format
+    bool verified; // The header info above comes from the ROM database, see rom_cache.h
+
+    // The mapped file, NULL if 'prg_rom' and 'chr_rom' were allocated separately
+    uint8_t *image;
+    size_t image_size;
+    atomic_int shares; // Owners besides the first, see rom_retain()
 } ROM;
 
 extern const uint8_t NES_TAG[TAG_LENGTH];
 
 ROM *get_rom(char *file_path);
+ROM *rom_retain(ROM *rom);
+void free_rom(ROM *rom);
 bool check_header(uint8_t *header);
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SHA1_LENGTH 20
+// Hex digits plus the terminator
+#define SHA1_STRING_LENGTH (SHA1_LENGTH * 2 + 1)
+
+uint32_t crc32_bytes(const uint8_t *bytes, size_t length);
+void sha1_bytes(const uint8_t *bytes, size_t length, uint8_t digest[SHA1_LENGTH]);
+void sha1_to_string(const uint8_t digest[SHA1_LENGTH], char string[SHA1_STRING_LENGTH]);
+bool sha1_from_string(const char *string, uint8_t digest[SHA1_LENGTH]);
+
+#endif
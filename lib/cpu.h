@@ -3,15 +3,20 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <SDL2/SDL.h>
 
-typedef struct Instruction Instruction;
 typedef struct Bus Bus;
 typedef struct ROM ROM;
 typedef enum Interrupt Interrupt;
 
 typedef struct CPU {
+    // Only holds the I, D and B bits, use 'get_status()' to read the whole register
     uint8_t status;
+    // N, V, Z and C are evaluated lazily
+    // Z and N are derived from the last result only when something reads them
+    uint8_t zero_result;
+    uint8_t negative_result;
+    bool carry;
+    bool overflow;
     uint16_t program_counter;
     uint8_t stack_pointer;
     uint8_t reg_a;
@@ -53,6 +58,7 @@ typedef struct CPU {
 #define PROGRAM_START_ADDR 0xFFFC
 
 CPU *new_cpu(ROM *rom);
+void cpu_create(CPU *cpu, Bus *bus);
 void destroy_cpu(CPU *cpu);
 
 // Memory functions
@@ -64,7 +70,7 @@ void mem_write_u16(CPU *cpu, uint16_t value, uint16_t addr);
 // Running functions
 void reset(CPU *cpu);
 void load(CPU *cpu);
-void run(CPU *cpu, SDL_Renderer *renderer, SDL_Texture *texture);
+bool run_frame(CPU *cpu);
 void interpret(CPU *cpu, uint8_t opcode);
 void interrupt(CPU *cpu, Interrupt interrupt_type);
 
@@ -74,6 +80,8 @@ void set_reg_x(CPU *cpu, uint8_t value);
 void set_reg_y(CPU *cpu, uint8_t value);
 
 // Flag functions
+uint8_t get_status(CPU *cpu);
+void set_status(CPU *cpu, uint8_t value);
 void set_flag(CPU *cpu, uint8_t flag);
 void unset_flag(CPU *cpu, uint8_t flag);
 bool is_set(CPU *cpu, uint8_t flag);
@@ -0,0 +1,45 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Accesses that don't reach any memory or register
+typedef enum DiagnosticEvent {
+    WriteOnlyRead,
+    UnmappedRead,
+    ReadOnlyWrite,
+    RomWrite,
+    UnmappedWrite,
+} DiagnosticEvent;
+
+#define DIAGNOSTIC_EVENTS 5
+#define DIAGNOSTIC_ADDRESSES 0x10000
+
+// Frames between two summaries
+#define DIAGNOSTICS_REPORT_INTERVAL 60
+
+/*
+    VERBOSITY LEVELS
+    0: Only counts, never reports
+    1: Reports a summary per event type
+    2: Also reports every address involved
+*/
+
+typedef struct Diagnostics {
+    int verbosity;
+    int frames_since_report;
+    uint64_t totals[DIAGNOSTIC_EVENTS]; // Since the start
+    uint32_t pending[DIAGNOSTIC_EVENTS]; // Since the last report
+    // Counters per event and address since the last report
+    // Only allocated once something is recorded at verbosity 2
+    uint32_t *address_counts;
+} Diagnostics;
+
+Diagnostics diagnostics_new(int verbosity);
+void diagnostics_destroy(Diagnostics *diagnostics);
+void diagnostics_record(Diagnostics *diagnostics, DiagnosticEvent event, uint16_t addr);
+void diagnostics_end_frame(Diagnostics *diagnostics);
+void diagnostics_report(Diagnostics *diagnostics, FILE *stream);
+
+#endif
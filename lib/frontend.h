@@ -0,0 +1,18 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+// Everything that needs SDL lives here, the rest of the emulator doesn't depend on it
+
+// Holding Tab only draws one frame out of FAST_FORWARD_PERIOD and drops the pacing
+#define FAST_FORWARD_PERIOD 8
+
+typedef struct NES NES;
+typedef struct Joypad Joypad;
+
+void run(NES *nes, SDL_Renderer *renderer, SDL_Texture *texture);
+bool handle_input(Joypad *joypad, SDL_Event *event);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct NES NES;
+
+typedef struct HeadlessOptions {
+    int frames; // Frames to run, 0 runs until the program stops
+    int until_addr; // Stops once the RAM byte at this address ($0000-$1FFF) equals 'until_value', -1 disables it
+    uint8_t until_value;
+    const char *dump_dir; // Writes every frame to this directory as a PPM image if not NULL
+    bool print_hashes; // Prints a hash of every frame
+    int skip_frames; // Frames not drawn out of every 'skip_period', they aren't hashed or dumped either
+    int skip_period;
+} HeadlessOptions;
+
+typedef struct HeadlessResult {
+    int frames;
+    bool stopped; // The program stopped by itself
+    bool condition_met;
+    double seconds;
+} HeadlessResult;
+
+HeadlessOptions headless_options_new(void);
+HeadlessResult run_headless(NES *nes, HeadlessOptions *options);
+
+// Hashing and dumping functions
+uint64_t hash_bytes(const uint8_t *bytes, int length);
+uint64_t hash_frame(const uint8_t *frame);
+uint64_t hash_ram(NES *nes);
+bool write_frame_ppm(const char *path, const uint8_t *frame);
+
+#endif
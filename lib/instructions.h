@@ -26,18 +26,19 @@ typedef enum AddrMode {
     Relative
 } AddrMode;
 
-typedef struct Instruction {
-    uint8_t opcode;
-    char mnemonic[5];
-    int bytes;
-    int cycles;
-    AddrMode mode;
-} Instruction;
+// Opcode data for disassembly, generated from the same list as the handlers, which have it compiled in
+// Page crossing penalties are up to each instruction, see get_operand()
+typedef struct OpcodeInfo {
+    uint8_t bytes;
+    uint8_t cycles;
+    uint8_t mode; // AddrMode
+} OpcodeInfo;
 
-extern Instruction inst_list[0x100];
+typedef void (*OpcodeHandler)(CPU *cpu);
 
-void populate_inst_list(void);
-Instruction get_instruction_from_opcode(uint8_t opcode);
+extern const OpcodeInfo OPCODE_TABLE[0x100];
+extern const char OPCODE_MNEMONICS[0x100][5]; // Only needed for disassembly
+extern const OpcodeHandler OPCODE_HANDLERS[0x100];
 
 // Instructions
 // In alphabetical order
@@ -151,6 +152,8 @@ void dcp(CPU *cpu, AddrMode mode);
 
 void isb(CPU *cpu, AddrMode mode);
 
+void kil(CPU *cpu);
+
 void lae(CPU *cpu, AddrMode mode);
 
 void lax(CPU *cpu, AddrMode mode);
@@ -3,40 +3,60 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <SDL2/SDL.h>
 
 #define FRAME_WIDTH 256
 #define FRAME_HEIGHT 240
 
+/*
+    FRAME LAYOUT
+    FRAME_PIXELS bytes, one per pixel, each an index into SYSTEM_PALETTE
+    Followed by FRAME_HEIGHT bytes, one per scanline, holding its color emphasis bits
+    7  bit  0
+    ---- ----
+    .... .BGR
+          |||
+          ||+- Emphasize red
+          |+-- Emphasize green
+          +--- Emphasize blue
+    Frames only become RGB when they are presented
+*/
+
+#define FRAME_PIXELS (FRAME_WIDTH * FRAME_HEIGHT)
+#define FRAME_SIZE (FRAME_PIXELS + FRAME_HEIGHT)
+#define FRAME_EMPHASIS_OFFSET FRAME_PIXELS
+
+#define EMPHASIS_RED   0b001
+#define EMPHASIS_GREEN 0b010
+#define EMPHASIS_BLUE  0b100
+
 #define SCALE 2
 
+#define FRAMES_PER_SECOND 60
+
 #define SCREEN_MEM 0x0200
 #define SCREEN_SIZE 0x0400
 
 #define RAND_NUM_ADDR 0xFE
 #define INPUT_ADDR 0xFF
 
-typedef struct CPU CPU;
-
 typedef struct Color {
     uint8_t r;
     uint8_t g;
     uint8_t b;
 } Color;
 
-extern Color SYSTEM_PALETTE[sizeof(Color) * 64];
-extern uint8_t frame[FRAME_WIDTH * FRAME_HEIGHT * 3];
-
-bool handle_input(CPU *cpu, SDL_Event *event);
+extern const Color SYSTEM_PALETTE[64];
 
 // Screen functions
-void draw_pixel(uint8_t *frame, int x, int y, Color color);
+void draw_pixel(uint8_t *frame, int x, int y, uint8_t color);
 void render_tiles(uint8_t *frame, uint8_t *chr_rom, int bank);
 
+// Conversion functions
+void frame_to_rgb24(const uint8_t *frame, uint8_t *rgb);
+void frame_to_xrgb8888(const uint8_t *frame, uint32_t *xrgb);
+
 // Color functions
 Color get_color(uint8_t byte);
 Color new_color(uint8_t red, uint8_t green, uint8_t blue);
 
-void palette_initialize(void);
-
 #endif
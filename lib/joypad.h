@@ -0,0 +1,45 @@
+#ifndef JOYPAD_H
+#define JOYPAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    JOYPAD BUTTON BITS
+    Buttons are reported through $4016/$4017 in this order, one bit per read
+    7  bit  0
+    ---- ----
+    RLDU TSBA
+    |||| ||||
+    |||| |||+- A
+    |||| ||+-- B
+    |||| |+--- Select
+    |||| +---- Start
+    |||+------ Up
+    ||+------- Down
+    |+-------- Left
+    +--------- Right
+*/
+
+#define JOYPAD_A      0b00000001
+#define JOYPAD_B      0b00000010
+#define JOYPAD_SELECT 0b00000100
+#define JOYPAD_START  0b00001000
+#define JOYPAD_UP     0b00010000
+#define JOYPAD_DOWN   0b00100000
+#define JOYPAD_LEFT   0b01000000
+#define JOYPAD_RIGHT  0b10000000
+
+typedef struct Joypad {
+    uint8_t buttons; // Latched once per frame by the frontend
+    uint8_t button_index;
+    bool strobe;
+} Joypad;
+
+Joypad joypad_new(void);
+void joypad_write(Joypad *joypad, uint8_t value);
+uint8_t joypad_read(Joypad *joypad);
+void joypad_set_buttons(Joypad *joypad, uint8_t buttons);
+void joypad_button_set(Joypad *joypad, uint8_t button, bool pressed);
+
+#endif
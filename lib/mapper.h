@@ -0,0 +1,73 @@
+#ifndef MAPPER_H
+#define MAPPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// PRG RAM window, carts with less PRG RAM have it mirrored across
+#define PRG_RAM_START 0x6000
+#define PRG_RAM_SIZE 0x2000
+
+// PRG ROM bank sizes used by the supported mappers
+#define PRG_BANK_8K 0x2000
+#define PRG_BANK_16K 0x4000
+#define PRG_BANK_32K 0x8000
+
+typedef struct Bus Bus;
+typedef struct ROM ROM;
+
+// MMC1 registers are loaded one bit per write through a 5 bit shift register
+typedef struct MMC1 {
+    uint8_t shift; // Bits written so far, under a 1 marking how many are left
+    uint8_t control;
+    uint8_t chr_bank_0;
+    uint8_t chr_bank_1;
+    uint8_t prg_bank;
+} MMC1;
+
+// The MMC3 IRQ counter is clocked by rising edges of PPU address line A12, which happen once per scanline
+// when the background and sprites use different pattern tables
+typedef struct MMC3 {
+    uint8_t bank_select;
+    uint8_t banks[8]; // R0-R7
+    uint8_t irq_latch;
+    uint8_t irq_counter;
+    bool irq_reload;
+    bool irq_enabled;
+} MMC3;
+
+typedef struct Mapper Mapper;
+
+// The cartridge hardware behind $6000-$FFFF and the pattern tables
+// Banks are switched by pointing bus pages and PPU CHR banks at other parts of the ROM, nothing is copied
+typedef struct Mapper {
+    int number;
+    // Handles writes to $8000-$FFFF, NULL if the board has no registers
+    void (*write)(Bus *bus, uint16_t addr, uint8_t value);
+    // Called on every rising edge of PPU A12, NULL if the board doesn't watch it
+    void (*a12_clock)(Mapper *mapper);
+    // Returns how many more A12 edges it takes to raise an IRQ, 0 if none is coming
+    int (*a12_clocks_until_irq)(Mapper *mapper);
+    bool irq; // IRQ line, held until the game acknowledges it
+
+    // Cart RAM, carved out of 'memory' by mapper_init() in the sizes the ROM asks for
+    uint8_t *memory;
+    size_t memory_size; // Bytes 'memory' holds, see mapper_memory_size()
+    uint8_t *prg_ram; // Behind $6000-$7FFF, NULL if the cart has none
+    int prg_ram_length;
+    uint8_t *chr_ram; // Pattern memory of carts without CHR ROM, NULL otherwise
+    int chr_ram_length;
+    union {
+        MMC1 mmc1;
+        MMC3 mmc3;
+        uint8_t bank; // UxROM, CNROM and AxROM only have a single register
+    } state;
+} Mapper;
+
+bool mapper_supported(int number);
+size_t mapper_memory_size(const ROM *rom);
+void mapper_init(Bus *bus, ROM *rom);
+bool mapper_write(Bus *bus, uint16_t addr, uint8_t value);
+
+#endif
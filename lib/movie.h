@@ -0,0 +1,29 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <stdint.h>
+
+// Joypad input recorded frame by frame
+typedef struct Movie {
+    uint8_t *pad_1;
+    uint8_t *pad_2;
+    int length; // In frames
+} Movie;
+
+/*
+    MOVIE FORMAT
+    Same input lines as FCEUX's '.fm2' files, every other line is ignored
+    |0|RLDUTSBA|RLDUTSBA||
+       |        |
+       |        +- Joypad 2
+       +---------- Joypad 1
+    A button is held if its letter is present, '.' or ' ' means released
+*/
+
+#define MOVIE_BUTTONS "RLDUTSBA"
+
+Movie *movie_load(const char *file_path);
+void movie_destroy(Movie *movie);
+uint8_t movie_parse_buttons(const char *field);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NES_H
+#define NES_H
+
+#include "io.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct CPU CPU;
+typedef struct Bus Bus;
+typedef struct PPU PPU;
+typedef struct ROM ROM;
+
+// Pieces of a console's arena start on cache line boundaries, so consoles on other threads don't share lines
+#define ARENA_ALIGNMENT 64
+
+// A whole console
+// Every piece of mutable state lives in here, so any number of instances can run in one process
+// Only read-only tables (opcodes, palette) and ROMs are shared between them
+// The struct starts an arena holding the CPU, bus, PPU and cart RAM, all of it is a single allocation
+typedef struct NES {
+    CPU *cpu;
+    Bus *bus;
+    PPU *ppu;
+    ROM *rom;
+    uint8_t frame[FRAME_SIZE]; // Palette indices, see FRAME LAYOUT in io.h
+} NES;
+
+NES *nes_new(ROM *rom);
+void nes_destroy(NES *nes);
+bool nes_load(NES *nes, ROM *rom);
+void nes_reset(NES *nes);
+bool nes_run_frame(NES *nes);
+void nes_set_frame_skip(NES *nes, int skip_frames, int skip_period);
+bool nes_frame_drawn(NES *nes);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef NES_VEC_H
+#define NES_VEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct NES NES;
+
+// What each step writes into the observation buffer, per console
+typedef enum Observation {
+    ObserveNone,
+    ObserveRam, // The 2 kB of work RAM
+    ObserveFrame, // The palette-indexed framebuffer, drawn straight into the buffer
+} Observation;
+
+// Steps many consoles in lockstep, one frame at a time
+// The consoles are split into fixed contiguous chunks, one per thread
+// The calling thread runs the first chunk, the others run on threads that live as long as the vector
+typedef struct NESVec {
+    NES **envs;
+    int count;
+    Observation observation;
+    uint8_t *observations; // Caller-provided, 'count' observations back to back
+    bool *done; // The program of this console stopped, it isn't stepped anymore
+
+    // Thread pool
+    pthread_t *threads;
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t finish;
+    int generation; // Incremented for every step
+    int pending; // Threads still working on the current step
+    bool exiting;
+
+    // Current step
+    const uint8_t *actions;
+    int step_count;
+} NESVec;
+
+NESVec *nes_vec_new(NES **envs, int count, int thread_count, Observation observation, uint8_t *observations);
+void nes_vec_destroy(NESVec *envs);
+int nes_vec_observation_size(Observation observation);
+void nes_vec_step(NESVec *envs, const uint8_t *actions, int n);
+void nes_vec_reset(NESVec *envs, int index);
+
+#endif
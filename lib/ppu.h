@@ -3,14 +3,33 @@
 
 #include "cartridge.h"
 #include "bus.h" // Must be included for 'Interrupt' enum
+#include "tile_cache.h"
 
 #include <stdint.h>
 #include <stdbool.h>
 
-typedef struct AddrRegister {
-    uint8_t value[2];
-    bool high_pointer;
-} AddrRegister;
+#define SCANLINE_CYCLES 341
+#define MAX_VISIBLE_SCANLINES 240
+#define MAX_SCANLINES 262
+#define VBLANK_SCANLINE 241
+#define PRE_RENDER_SCANLINE 261
+
+// Dots into a frame at which PPU state visible to the CPU changes
+#define VBLANK_DOT (VBLANK_SCANLINE * SCANLINE_CYCLES + 1)
+#define PRE_RENDER_DOT (PRE_RENDER_SCANLINE * SCANLINE_CYCLES + 1)
+#define SCROLL_RELOAD_DOT (PRE_RENDER_SCANLINE * SCANLINE_CYCLES + 304)
+#define FRAME_DOTS (MAX_SCANLINES * SCANLINE_CYCLES)
+
+// Dot of a visible scanline after its last pixel, where it is drawn
+#define SCANLINE_END_DOT 257
+
+// Dots of a rendered scanline at which PPU address line A12 rises, see ppu_a12_rise_dot()
+#define A12_SPRITE_FETCH_DOT 260
+#define A12_BACKGROUND_FETCH_DOT 324
+
+#define OAM_SPRITES 64
+#define SPRITE_BYTES 4
+#define MAX_SCANLINE_SPRITES 8
 
 typedef struct PPU {
     // Registers
@@ -19,33 +38,78 @@ typedef struct PPU {
     uint8_t status; // 0x2002
     uint8_t oam_addr; // 0x2003
     uint8_t oam_data_reg; // 0x2004
-    uint8_t scroll; // 0x2005
-    AddrRegister addr; // 0x2006
     uint8_t data; // 0x2007
     uint8_t oam_dma; // 0x4014
+
+    // Internal registers behind 0x2005 and 0x2006, see LOOPY REGISTERS below
+    uint16_t v; // Current VRAM address, also the scroll position while rendering
+    uint16_t t; // Temporary VRAM address, the scroll position of the top left pixel
+    uint8_t fine_x; // Fine X scroll, 3 bits
+    bool write_toggle; // The next write to 0x2005 or 0x2006 is the second one
+
+    // 0x2007 writes land in the 1 kB window at 'data_window' through 'data_target' until 'v' leaves it
+    // 'data_target' is NULL when writes to the window need special handling
+    // Anything that remaps PPU memory must set 'data_window' to DATA_WINDOW_NONE
+    uint8_t *data_target;
+    uint16_t data_window;
+    uint8_t data_stride; // 1 or 32, from VRAM_ADDR_INCREMENT
     
     // Temporary buffer to hold data read from memory
     uint8_t internal_data_buffer;
     
     // Memory
-    uint8_t *chr_rom;
+    uint8_t *chr_banks[CHR_BANKS]; // Pattern memory behind each 1 kB of $0000-$1FFF, see ppu_map_chr()
+    bool chr_ram; // Pattern memory is writable through 0x2007
     uint8_t palette_table[32];
-    uint8_t vram[2048];
+    uint8_t vram[4096]; // 2 kB inside the console, the other 2 kB are only used by four-screen carts
+    uint8_t *nametables[4]; // Memory behind each of the four nametables, see ppu_set_mirroring()
     uint8_t oam_data[256];
 
+    // Decoded pattern tables, must be invalidated whenever the memory behind 'chr_banks' changes
+    TileCache tile_cache;
+
+    // Sprites found on each visible scanline, in OAM order
+    // Only rebuilt when OAM or the sprite size changed since the last evaluation
+    uint8_t scanline_sprites[MAX_VISIBLE_SCANLINES][MAX_SCANLINE_SPRITES];
+    uint8_t scanline_sprite_count[MAX_VISIBLE_SCANLINES];
+    int overflow_scanline; // First scanline that sets SPRITE_OVERFLOW, -1 if none
+    bool sprites_dirty;
+
+    // Framebuffer owned by the emulator instance, nothing is drawn if NULL
+    // Holds palette indices, see FRAME LAYOUT in io.h
+    uint8_t *frame;
+
     Mirroring mirroring;
-    int cycle;
-    int scanline;
+
+    // The PPU only catches up when an event is due or the CPU accesses its registers
+    int dot; // Dots elapsed in the current frame, may run ahead of what was drawn
+    int next_event; // Dot of the next event, see ppu_sync()
+    int next_sync; // Dot ppu_tick() syncs at, 'next_event' or an earlier sprite 0 hit or cartridge IRQ
+    int sprite_zero_hit_dot; // Dot the next sprite 0 hit shows up in $2002 at, -1 if none is due this frame
+    int drawn_scanlines; // Visible scanlines already processed this frame
+    bool frame_complete; // Set when vblank starts, cleared by bus_poll_for_frame()
+
+    // Frame skipping, the first 'skip_frames' of every 'skip_period' frames are not drawn
+    // Status flags are still computed, so the game runs the same either way
+    int skip_frames;
+    int skip_period;
+    int frame_number; // Frames started since power-up
+
+    // Cartridge hardware clocked by A12 rising edges, NULL if the board doesn't watch A12
+    Mapper *mapper;
+    int a12_scanlines; // Scanlines whose A12 edge has been passed this frame
 
     Interrupt interrupt;
 } PPU;
 
-#define SCANLINE_CYCLES 341
-#define MAX_VISIBLE_SCANLINES 240
-#define MAX_SCANLINES 262
-
-PPU *ppu_new(uint8_t *chr_rom, Mirroring mirroring);
+PPU *ppu_new(ROM *rom);
+void ppu_create(PPU *ppu, ROM *rom);
+void ppu_init(PPU *ppu, ROM *rom);
 Interrupt ppu_tick(PPU *ppu, int cycles);
+void ppu_sync(PPU *ppu);
+void ppu_reschedule(PPU *ppu);
+void ppu_set_frame_skip(PPU *ppu, int skip_frames, int skip_period);
+bool ppu_frame_drawn(PPU *ppu);
 
 /*
     CONTROLLER REGISTER BITS
@@ -77,12 +141,92 @@ Interrupt ppu_tick(PPU *ppu, int cycles);
 #define MASTER_SLAVE            0b01000000
 #define GENERATE_NMI            0b10000000
 
+/*
+    LOOPY REGISTERS
+    'v' and 't' share this layout, addressing a nametable byte when used as a VRAM address
+
+    yyy NN YYYYY XXXXX
+    ||| || ||||| +++++- Coarse X scroll
+    ||| || +++++------- Coarse Y scroll
+    ||| ++------------- Nametable select
+    +++---------------- Fine Y scroll
+
+    Writes to 0x2000 and 0x2005 only change 't', which is copied to 'v' by the second write to 0x2006
+    While rendering, the horizontal bits are copied again after every scanline and all of them before every frame
+*/
+
+#define SCROLL_COARSE_X    0x001F
+#define SCROLL_COARSE_Y    0x03E0
+#define SCROLL_NAMETABLE_X 0x0400
+#define SCROLL_NAMETABLE_Y 0x0800
+#define SCROLL_FINE_Y      0x7000
+#define SCROLL_HORIZONTAL  (SCROLL_COARSE_X | SCROLL_NAMETABLE_X)
+
+#define PALETTE_START 0x3F00
+
+// Size of the windows the 0x2007 write fast path resolves at once, nametables and CHR banks come in these units
+#define DATA_WINDOW_SIZE 0x400
+#define DATA_WINDOW_NONE 0xFFFF
+
 // Controller register functions
 bool ppu_controller_bit_is_set(PPU *ppu, uint8_t flag);
 void ppu_controller_bit_set(PPU *ppu, uint8_t flag);
 void ppu_controller_bit_unset(PPU *ppu, uint8_t flag);
 void ppu_controller_register_set(PPU *ppu, uint8_t value);
 
+/*
+    MASK REGISTER BITS
+
+    7  bit  0
+    ---- ----
+    BGRs bMmG
+    |||| ||||
+    |||| |||+- Greyscale (0: normal color, 1: greyscale)
+    |||| ||+-- 1: Show background in leftmost 8 pixels of screen, 0: Hide
+    |||| |+--- 1: Show sprites in leftmost 8 pixels of screen, 0: Hide
+    |||| +---- 1: Show background
+    |||+------ 1: Show sprites
+    ||+------- Emphasize red
+    |+-------- Emphasize green
+    +--------- Emphasize blue
+*/
+
+#define GREYSCALE            0b00000001
+#define SHOW_BACKGROUND_LEFT 0b00000010
+#define SHOW_SPRITES_LEFT    0b00000100
+#define SHOW_BACKGROUND      0b00001000
+#define SHOW_SPRITES         0b00010000
+#define EMPHASIZE_RED        0b00100000
+#define EMPHASIZE_GREEN      0b01000000
+#define EMPHASIZE_BLUE       0b10000000
+
+/*
+    OAM SPRITE BYTES
+
+    0: Y position of the top of the sprite, minus one
+    1: Tile index (8x16 sprites take their pattern table from bit 0)
+    2: Attributes
+       7  bit  0
+       ---- ----
+       VHP. ..PP
+       |||    ||
+       |||    ++- Palette (4 to 7) of sprite
+       ||+------- Priority (0: in front of background; 1: behind background)
+       |+-------- Flip sprite horizontally
+       +--------- Flip sprite vertically
+    3: X position of the left side of the sprite
+*/
+
+#define SPRITE_Y         0
+#define SPRITE_TILE      1
+#define SPRITE_ATTRIBUTE 2
+#define SPRITE_X         3
+
+#define SPRITE_PALETTE           0b00000011
+#define SPRITE_BEHIND_BACKGROUND 0b00100000
+#define SPRITE_FLIP_HORIZONTAL   0b01000000
+#define SPRITE_FLIP_VERTICAL     0b10000000
+
 // Status register defines
 #define NOTUSED1        0b00000001
 #define NOTUSED2        0b00000010
@@ -101,10 +245,17 @@ bool ppu_statuts_bit_is_set(PPU *ppu, uint8_t flag);
 // Memory functions
 uint8_t ppu_mem_read(PPU *ppu);
 void ppu_mem_write(PPU *ppu, uint8_t value);
+uint8_t ppu_read_status(PPU *ppu);
 
 // VRAM functions
 void ppu_vram_addr_increment(PPU *ppu);
-uint16_t ppu_mirror_vram_addr(PPU *ppu, uint16_t addr);
+void ppu_set_mirroring(PPU *ppu, Mirroring mirroring);
+void ppu_map_chr(PPU *ppu, int bank, uint8_t *memory, int count);
+
+// Returns the nametable byte at 'addr', which must be between 0x2000 and 0x3EFF
+static inline uint8_t *ppu_nametable_byte(PPU *ppu, uint16_t addr) {
+    return &ppu->nametables[(addr >> 10) & 3][addr & 0x3FF];
+}
 
 // Write to register functions
 void ppu_write_to_controller(PPU *ppu, uint8_t value);
@@ -114,14 +265,7 @@ void ppu_write_to_oam_data(PPU *ppu, uint8_t value);
 void ppu_write_to_scroll(PPU *ppu, uint8_t value);
 void ppu_write_to_ppu_addr(PPU *ppu, uint8_t value);
 void ppu_write_to_ppu_data(PPU *ppu, uint8_t value);
-void ppu_write_to_oam_dma(PPU *ppu, uint8_t value);
-
-// AddrRegister functions
-AddrRegister addrregister_new(void);
-void addrregister_set(AddrRegister addr_reg, uint16_t value);
-void addrregister_update(AddrRegister addr_reg, uint8_t value);
-void addrregister_increment(AddrRegister addr_reg, uint8_t value);
-void addrregister_reset_pointer(AddrRegister addr_reg);
-uint16_t addrregister_get(AddrRegister addr_reg);
+void ppu_write_to_oam_dma(PPU *ppu, uint8_t value, const uint8_t *page);
+uint8_t ppu_read_oam_data(PPU *ppu);
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "tile_cache.h"
+
+#include <stdint.h>
+
+typedef struct PPU PPU;
+
+#define NAMETABLE_START 0x2000
+#define NAMETABLE_SIZE 0x400
+#define ATTRIBUTE_TABLE_OFFSET 0x3C0
+#define NAMETABLE_COLUMNS 32
+#define NAMETABLE_ROWS 30
+
+#define PATTERN_TABLE_SIZE 0x1000
+#define PATTERN_TABLE_TILES 256
+
+// Returned by sprite_zero_hit_x() when no scanline can hit
+#define SPRITE_ZERO_NEVER_HITS -2
+
+/*
+    SCANLINE BUFFER
+    Every pixel of a scanline is first rendered as an index into 'palette_table'
+    ---P PPCC
+       | ||++- Color inside the palette, 0 is transparent
+       +-++--- Palette, 0-3 are background palettes and 4-7 sprite palettes
+*/
+
+// Rendering functions
+void render_scanline(PPU *ppu, int scanline);
+void render_background(PPU *ppu, uint16_t v, uint8_t *line);
+void render_sprites(PPU *ppu, int scanline, uint8_t *line);
+void render_sprite_overflow(PPU *ppu, int scanline);
+int sprite_zero_hit_x(PPU *ppu, int scanline, uint16_t v, int first_x);
+
+// Sprite functions
+void sprite_evaluate(PPU *ppu);
+int sprite_height(PPU *ppu);
+const uint8_t *sprite_row(PPU *ppu, const uint8_t *sprite, int scanline);
+
+#endif
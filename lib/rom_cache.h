@@ -0,0 +1,32 @@
+#ifndef ROM_CACHE_H
+#define ROM_CACHE_H
+
+#include "cartridge.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+
+/*
+    ROM DATABASE FORMAT
+    One record per line, lines starting with '#' are comments
+
+    rom <crc32> <sha1 | -> <mapper> <H | V | 4> <prg ram kB> <battery 0 | 1>
+        Header info for the ROM whose PRG and CHR hash to <crc32> and <sha1>, used over the file's iNES header
+        The mirroring is horizontal, vertical or four-screen. '-' matches on the CRC alone
+        The PRG RAM size counts all of it, the battery keeps all of it or none
+    seen <crc32> <sha1> <mapper> <H | V | 4> <prg ram kB> <battery 0 | 1>
+        Header info of a ROM as its file gave it, never applied. Turning it into a 'rom' record confirms it
+    file <size> <mtime seconds> <mtime nanoseconds> <crc32> <sha1> <path>
+        Hashes of a file as of its size and modification time, so loading it again skips hashing
+*/
+
+#define ROM_DATABASE_LINE_LENGTH 4096
+
+ROM *rom_cache_find_file(const char *file_path, const struct stat *info);
+ROM *rom_cache_add(ROM *rom, const char *file_path, const struct stat *info);
+bool rom_cache_load_database(const char *file_path);
+bool rom_cache_save_database(const char *file_path);
+void rom_cache_clear(void);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TILE_BYTES 16 // Two 8 byte bitplanes
+#define TILE_SIZE 8 // In pixels
+#define TILE_PIXELS (TILE_SIZE * TILE_SIZE)
+
+// Both pattern tables, $0000-$1FFF
+#define CACHED_TILES 512
+
+// Pattern memory is seen through 8 banks of 1 kB, which mappers can point anywhere in CHR memory
+#define CHR_BANK_SIZE 0x400
+#define CHR_BANKS 8
+#define CHR_BANK_TILES (CHR_BANK_SIZE / TILE_BYTES)
+
+// Every tile the PPU can address, decoded to one byte (0-3) per pixel
+// Tiles are decoded lazily, the first time they are used after being invalidated
+typedef struct TileCache {
+    uint8_t pixels[CACHED_TILES][TILE_PIXELS];
+    uint8_t flipped[CACHED_TILES][TILE_PIXELS]; // Mirrored horizontally
+    bool dirty[CACHED_TILES];
+} TileCache;
+
+void tile_cache_init(TileCache *cache);
+void tile_cache_invalidate(TileCache *cache, uint16_t addr, int length);
+void tile_cache_decode(TileCache *cache, const uint8_t *data, int tile);
+void tile_decode(const uint8_t *tile, uint8_t *pixels, bool flipped);
+
+// Returns the 8 pixels of one row of 'tile', decoding it from the CHR bank holding it first if needed
+static inline const uint8_t *tile_cache_row(TileCache *cache, uint8_t *const *chr_banks, int tile, int row, bool flipped) {
+    if (cache->dirty[tile]) {
+        tile_cache_decode(cache, chr_banks[tile / CHR_BANK_TILES] + (tile % CHR_BANK_TILES) * TILE_BYTES, tile);
+    }
+    return (flipped ? cache->flipped[tile] : cache->pixels[tile]) + row * TILE_SIZE;
+}
+
+#endif
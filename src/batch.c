@@ -0,0 +1,284 @@
+#include "../lib/batch.h"
+#include "../lib/nes.h"
+#include "../lib/bus.h"
+#include "../lib/cartridge.h"
+#include "../lib/joypad.h"
+#include "../lib/movie.h"
+#include "../lib/headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Shared by every worker of a batch, jobs are handed out in manifest order
+typedef struct BatchQueue {
+    Batch *batch;
+    int next_job;
+    pthread_mutex_t lock;
+} BatchQueue;
+
+typedef struct BatchWorker {
+    BatchQueue *queue;
+    int index;
+} BatchWorker;
+
+static double seconds_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static char *copy_string(const char *string) {
+    char *copy = malloc(strlen(string) + 1);
+    strcpy(copy, string);
+    return copy;
+}
+
+Batch *batch_load_manifest(const char *file_path) {
+    FILE *file = fopen(file_path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Couldn't open manifest '%s'.\n", file_path);
+        return NULL;
+    }
+
+    Batch *batch = malloc(sizeof(Batch));
+    int capacity = 64;
+    batch->jobs = malloc(sizeof(BatchJob) * capacity);
+    batch->job_count = 0;
+    batch->results = NULL;
+    batch->workers = NULL;
+    batch->worker_count = 0;
+    batch->seconds = 0;
+
+    char line[MANIFEST_LINE_LENGTH];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char rom_path[MANIFEST_LINE_LENGTH];
+        char movie_path[MANIFEST_LINE_LENGTH];
+        int frames;
+
+        char *start = line + strspn(line, " \t");
+        if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0') {
+            continue;
+        }
+        if (sscanf(start, "%s %s %i", rom_path, movie_path, &frames) != 3 || frames < 0) {
+            fprintf(stderr, "Invalid job at line %i of '%s'.\n", line_number, file_path);
+            fclose(file);
+            batch_destroy(batch);
+            return NULL;
+        }
+
+        if (batch->job_count == capacity) {
+            capacity *= 2;
+            batch->jobs = realloc(batch->jobs, sizeof(BatchJob) * capacity);
+        }
+        BatchJob *job = &batch->jobs[batch->job_count++];
+        job->rom_path = copy_string(rom_path);
+        job->movie_path = strcmp(movie_path, "-") == 0 ? NULL : copy_string(movie_path);
+        job->frames = frames;
+        job->rom = NULL;
+    }
+    fclose(file);
+
+    batch->results = calloc(batch->job_count > 0 ? batch->job_count : 1, sizeof(BatchResult));
+    return batch;
+}
+
+void batch_destroy(Batch *batch) {
+    for (int i = 0; i < batch->job_count; i++) {
+        free(batch->jobs[i].rom_path);
+        free(batch->jobs[i].movie_path);
+        if (batch->jobs[i].rom != NULL) {
+            free_rom(batch->jobs[i].rom);
+        }
+    }
+    free(batch->jobs);
+    free(batch->results);
+    free(batch->workers);
+    free(batch);
+}
+
+// One worker per online core
+int batch_default_workers(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long cores = info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return cores > 0 ? cores : 1;
+}
+
+// Loads every ROM of the batch once, jobs on the same file share it
+// Files get_rom() has seen before come out of the ROM cache
+static void map_roms(Batch *batch) {
+    for (int i = 0; i < batch->job_count; i++) {
+        BatchJob *job = &batch->jobs[i];
+        if (job->rom != NULL) {
+            continue;
+        }
+        int earlier = 0;
+        while (earlier < i && strcmp(batch->jobs[earlier].rom_path, job->rom_path) != 0) {
+            earlier++;
+        }
+        if (earlier < i) {
+            // A file that failed to load isn't tried again
+            if (batch->jobs[earlier].rom != NULL) {
+                job->rom = rom_retain(batch->jobs[earlier].rom);
+            }
+        }
+        else {
+            job->rom = get_rom(job->rom_path);
+        }
+    }
+}
+
+// Runs a single job on the worker's console
+static void run_job(NES **nes, BatchJob *job, BatchResult *result) {
+    if (job->rom == NULL) {
+        return;
+    }
+    if (*nes == NULL) {
+        *nes = nes_new(rom_retain(job->rom));
+    }
+    else if ((*nes)->rom != job->rom) {
+        // Consoles only have room for the cart RAM of the ROM they were built for
+        ROM *rom = rom_retain(job->rom);
+        if (!nes_load(*nes, rom)) {
+            nes_destroy(*nes);
+            *nes = nes_new(rom);
+        }
+    }
+    else {
+        nes_load(*nes, (*nes)->rom);
+    }
+    // The job fails, the worker's next job tries to make a console again
+    if (*nes == NULL) {
+        return;
+    }
+
+    Movie *movie = NULL;
+    if (job->movie_path != NULL) {
+        movie = movie_load(job->movie_path);
+        if (movie == NULL) {
+            return;
+        }
+    }
+
+    // Only the last frame is hashed, so it's the only one drawn
+    if (job->frames > 0) {
+        nes_set_frame_skip(*nes, job->frames - 1, job->frames);
+    }
+    else {
+        nes_set_frame_skip(*nes, 0, 1);
+    }
+    nes_reset(*nes);
+    double start = seconds_now();
+    while (result->frames < job->frames) {
+        if (movie != NULL && result->frames < movie->length) {
+            joypad_set_buttons(&(*nes)->bus->joypad_1, movie->pad_1[result->frames]);
+            joypad_set_buttons(&(*nes)->bus->joypad_2, movie->pad_2[result->frames]);
+        }
+        if (!nes_run_frame(*nes)) {
+            result->stopped = true;
+            break;
+        }
+        result->frames++;
+    }
+    result->seconds = seconds_now() - start;
+    result->success = true;
+    result->ram_hash = hash_ram(*nes);
+    result->frame_hash = hash_frame((*nes)->frame);
+
+    if (movie != NULL) {
+        movie_destroy(movie);
+    }
+}
+
+static void *batch_worker(void *arg) {
+    BatchWorker *worker = arg;
+    BatchQueue *queue = worker->queue;
+    BatchWorkerStats *stats = &queue->batch->workers[worker->index];
+    // Every worker keeps a single console for all its jobs
+    NES *nes = NULL;
+
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        int job_index = queue->next_job++;
+        pthread_mutex_unlock(&queue->lock);
+        if (job_index >= queue->batch->job_count) {
+            break;
+        }
+
+        BatchResult *result = &queue->batch->results[job_index];
+        memset(result, 0, sizeof(BatchResult));
+        result->worker = worker->index;
+        run_job(&nes, &queue->batch->jobs[job_index], result);
+
+        stats->jobs++;
+        stats->frames += result->frames;
+        stats->seconds += result->seconds;
+    }
+
+    if (nes != NULL) {
+        nes_destroy(nes);
+    }
+    return NULL;
+}
+
+// Runs every job of the batch on 'worker_count' threads
+// Returns false if the workers couldn't be started
+bool batch_run(Batch *batch, int worker_count) {
+    if (worker_count < 1) {
+        worker_count = batch_default_workers();
+    }
+    if (worker_count > batch->job_count && batch->job_count > 0) {
+        worker_count = batch->job_count;
+    }
+
+    map_roms(batch);
+
+    free(batch->workers);
+    batch->workers = calloc(worker_count, sizeof(BatchWorkerStats));
+    batch->worker_count = worker_count;
+
+    BatchQueue queue;
+    queue.batch = batch;
+    queue.next_job = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * worker_count);
+    BatchWorker *workers = malloc(sizeof(BatchWorker) * worker_count);
+    double start = seconds_now();
+
+    int started = 0;
+    for (int i = 0; i < worker_count; i++) {
+        workers[i].queue = &queue;
+        workers[i].index = i;
+        if (pthread_create(&threads[i], NULL, batch_worker, &workers[i]) != 0) {
+            fprintf(stderr, "Couldn't start worker %i.\n", i);
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    batch->seconds = seconds_now() - start;
+    pthread_mutex_destroy(&queue.lock);
+    free(threads);
+    free(workers);
+    return started > 0;
+}
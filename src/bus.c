@@ -5,109 +5,156 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
-#include <stdio.h>
 
 Bus *new_bus(ROM *rom) {
     Bus *bus = malloc(sizeof(Bus));
+    size_t cart_memory_size = mapper_memory_size(rom);
+    bus_create(bus, ppu_new(rom), malloc(cart_memory_size), cart_memory_size, rom);
+    return bus;
+}
+
+// Builds a bus in memory owned by the caller, around 'ppu' and 'cart_memory_size' bytes of cart RAM
+void bus_create(Bus *bus, PPU *ppu, uint8_t *cart_memory, size_t cart_memory_size, ROM *rom) {
+    bus->ppu = ppu;
+    bus->diagnostics = diagnostics_new(0);
+    bus->mapper.memory = cart_memory;
+    bus->mapper.memory_size = cart_memory_size;
+    bus_load_rom(bus, rom);
+}
+
+// Puts the bus and the PPU back in their power-up state with 'rom' inserted
+// Nothing is reallocated, so a bus can be reused for many runs
+// 'rom' must fit in the bus' cart RAM, see mapper_memory_size()
+void bus_load_rom(Bus *bus, ROM *rom) {
     bus->rom = rom;
     memset(bus->ram, 0, sizeof(bus->ram));
-    bus->ppu = ppu_new(rom->chr_rom, rom->mirroring); 
+    ppu_init(bus->ppu, rom);
     bus->cycles = 0;
-    return bus;
+    bus->joypad_1 = joypad_new();
+    bus->joypad_2 = joypad_new();
+
+    memset(bus->read_pages, 0, sizeof(bus->read_pages));
+    memset(bus->write_pages, 0, sizeof(bus->write_pages));
+
+    // RAM is mirrored 4 times up to 0x1FFF
+    for (int addr = RAM_START; addr < RAM_MIRROR_END; addr += sizeof(bus->ram)) {
+        bus_map_memory(bus, addr, sizeof(bus->ram), bus->ram, true);
+    }
+    // The mapper takes care of $6000-$FFFF and the pattern tables
+    mapper_init(bus, rom);
+}
+
+// Points the pages covering 'size' bytes from 'addr' at 'memory'
+// Both 'addr' and 'size' must be multiples of the page size
+// Mappers switch banks by remapping pages
+void bus_map_memory(Bus *bus, uint16_t addr, int size, uint8_t *memory, bool writable) {
+    int first_page = addr / BUS_PAGE_SIZE;
+    for (int i = 0; i < size / BUS_PAGE_SIZE; i++) {
+        uint8_t *page = memory + i * BUS_PAGE_SIZE;
+        bus->read_pages[first_page + i] = page;
+        bus->write_pages[first_page + i] = writable ? page : NULL;
+    }
 }
 
 Interrupt bus_tick(Bus *bus, int cycles) {
-    bus->cycles += cycles;
     Interrupt return_value = ppu_tick(bus->ppu, cycles * 3); // Multiplies cycles by 3 because each CPU cycle is 3 PPU cycles
+    // Cartridge IRQs stay up until acknowledged, an NMI goes first
+    if (return_value == None && bus->mapper.irq) {
+        return IRQ;
+    }
     return return_value;
 }
 
 uint8_t bus_mem_read(Bus *bus, uint16_t addr) {
-    // RAM
-    if (addr >= RAM_START && addr <= RAM_MIRROR_END) {
-        // RAM only takes into account the first 11 bits
-        // This takes care of mirroring
-        addr &= 0b11111111111;
-        return bus->ram[addr];
+    // RAM and ROM are read straight through the page table
+    uint8_t *page = bus->read_pages[addr >> 8];
+    if (page != NULL) {
+        return page[addr & 0xFF];
     }
     // PPU memory access
-    else if (addr == 0x2000 || addr == 0x2001 || addr == 0x2003 || addr == 0x2005 || addr == 0x2006 || addr == 0x4014) {
-        fprintf(stderr, "Tried to read write-only ppu register at %04X\n", addr);
+    if (addr == 0x2000 || addr == 0x2001 || addr == 0x2003 || addr == 0x2005 || addr == 0x2006 || addr == 0x4014) {
+        diagnostics_record(&bus->diagnostics, WriteOnlyRead, addr);
         return 0;
     }
     // Read from the status register
     else if (addr == 0x2002) {
-        // Reads only the 3 most significant bits. The other 5 come from the buffer
-        uint8_t data = (bus->ppu->status & 0xE0) | (bus->ppu->internal_data_buffer & 0x1F);
-        ppu_status_bit_unset(bus->ppu, VBLANK_STARTED); // Reading unsets the VBLANK flag
-        //bus->ppu->addr_latch = true; // Also resets the pointer of the address register
-        return data;
+        ppu_sync(bus->ppu);
+        return ppu_read_status(bus->ppu);
+    }
+    else if (addr == 0x2004) {
+        ppu_sync(bus->ppu);
+        return ppu_read_oam_data(bus->ppu);
     }
     else if (addr == 0x2007) {
-        return ppu_mem_read(bus->ppu);
+        ppu_sync(bus->ppu);
+        uint8_t data = ppu_mem_read(bus->ppu);
+        ppu_vram_addr_increment(bus->ppu); // Reading from the data register increments the addr register as well
+        // Moving 'v' moves the scroll position sprite 0 hits are predicted with
+        ppu_reschedule(bus->ppu);
+        return data;
     }
     // Access to area mirroring PPU registers
     else if (addr >= PPU_MIRROR_START && addr <= PPU_MIRROR_END) {
         uint16_t mirrored_down_addr = addr & 0b0010000000000111;
         return bus_mem_read(bus, mirrored_down_addr);   
     }
-    // PRG ROM
-    else if (addr >= PRG_ROM_START && addr <= PRG_ROM_MIRROR_END) {
-        addr -= PRG_ROM_START;
-        // Mirror if needed
-        if (bus->rom->prg_rom_length == 0x4000) {
-            addr %= 0x4000;
-        }
-        return bus->rom->prg_rom[addr];
+    else if (addr == 0x4016) {
+        return joypad_read(&bus->joypad_1);
+    }
+    else if (addr == 0x4017) {
+        return joypad_read(&bus->joypad_2);
     }
     else {
-        fprintf(stderr, "Ignoring memory access at address %04X.\n", addr);
+        diagnostics_record(&bus->diagnostics, UnmappedRead, addr);
         return 0;
     }
 }
 
 void bus_mem_write(Bus *bus, uint8_t value, uint16_t addr) {
-    // RAM
-    if (addr >= RAM_START && addr <= RAM_MIRROR_END) {
-        // RAM only takes into account the first 11 bits
-        // This takes care of mirroring
-        addr &= 0b11111111111;
-        bus->ram[addr] = value;
+    // RAM is written straight through the page table
+    uint8_t *page = bus->write_pages[addr >> 8];
+    if (page != NULL) {
+        page[addr & 0xFF] = value;
         return;
     }
     
     // PPU
-    else if (addr >= 0x2000 && addr <= 0x2007) {
+    if (addr >= 0x2000 && addr <= 0x2007) {
+        // Everything drawn so far must see the registers as they were
+        ppu_sync(bus->ppu);
         switch (addr) {
             case 0x2000:
                 ppu_write_to_controller(bus->ppu, value);
-                return;
+                break;
             case 0x2001:
                 ppu_write_to_mask(bus->ppu, value);
-                return;
+                break;
             case 0x2002:
-                fprintf(stderr, "Attempted to write to read-only PPU status register.\n");
-                return;
+                diagnostics_record(&bus->diagnostics, ReadOnlyWrite, addr);
+                break;
             case 0x2003:
                 ppu_write_to_oam_addr(bus->ppu, value);
-                return;
+                break;
             case 0x2004:
                 ppu_write_to_oam_data(bus->ppu, value);
-                return;
+                break;
             case 0x2005:
                 ppu_write_to_scroll(bus->ppu, value);
-                return;
+                break;
             case 0x2006:
                 ppu_write_to_ppu_addr(bus->ppu, value);
-                return;
+                break;
             case 0x2007:
                 ppu_write_to_ppu_data(bus->ppu, value);
-                    ppu_vram_addr_increment(bus->ppu); // Writing to the data register increments the addr register
-                return;
+                ppu_vram_addr_increment(bus->ppu); // Writing to the data register increments the addr register
+                break;
             default:
-                fprintf(stderr, "Tried to access unknown PPU register: %04X.\n", addr);
-                return;
+                diagnostics_record(&bus->diagnostics, UnmappedWrite, addr);
+                break;
         }
+        // The write may have moved the next sprite 0 hit or A12 edge
+        ppu_reschedule(bus->ppu);
+        return;
     }
     // PPU mirror space
     else if (addr >= PPU_MIRROR_START && addr <= PPU_MIRROR_END) {
@@ -116,24 +163,63 @@ void bus_mem_write(Bus *bus, uint8_t value, uint16_t addr) {
         return;
     }
     else if (addr == 0x4014) {
-        ppu_write_to_oam_dma(bus->ppu, value);
+        bus_oam_dma(bus, value);
+        return;
+    }
+    // Strobes both joypads
+    else if (addr == 0x4016) {
+        joypad_write(&bus->joypad_1, value);
+        joypad_write(&bus->joypad_2, value);
         return;
     }
-    // PRG ROM
+    // PRG ROM, where writes go to the mapper's registers
     else if (addr >= PRG_ROM_START && addr <= PRG_ROM_MIRROR_END) {
-        fprintf(stderr, "Error: attempted to write to PRG ROM space at %04X.\n", addr);
+        if (!mapper_write(bus, addr, value)) {
+            diagnostics_record(&bus->diagnostics, RomWrite, addr);
+        }
         return;
     }
     else  {
-        fprintf(stderr, "Attempted to write to non-handled address at %04X.\n", addr);
+        diagnostics_record(&bus->diagnostics, UnmappedWrite, addr);
         return;
     }
 }
 
+// Copies CPU page 'page' into OAM
+// The CPU is stalled meanwhile, the stall is added to the cycles of the instruction that started it
+void bus_oam_dma(Bus *bus, uint8_t page) {
+    uint8_t *memory = bus->read_pages[page];
+    uint8_t buffer[BUS_PAGE_SIZE];
+    if (memory == NULL) {
+        // Pages without direct memory behind them are read one byte at a time, in case reads have side effects
+        for (int i = 0; i < BUS_PAGE_SIZE; i++) {
+            buffer[i] = bus_mem_read(bus, page << 8 | i);
+        }
+        memory = buffer;
+    }
+    // Sprites already drawn must not see the new OAM
+    ppu_sync(bus->ppu);
+    ppu_write_to_oam_dma(bus->ppu, page, memory);
+    ppu_reschedule(bus->ppu);
+    // One more cycle to align with the CPU's read cycles when starting on an odd one
+    // 'cycles' already counts the whole instruction up to this write, see the handlers in instructions.c
+    bus->cycles += OAM_DMA_CYCLES + (bus->cycles & 1);
+}
+
 Interrupt bus_poll_for_interrupt(Bus *bus) {
+    if (bus->ppu->interrupt == None && bus->mapper.irq) {
+        return IRQ;
+    }
     return bus->ppu->interrupt;
 }
 
 void bus_clear_interrupt(Bus *bus) {
     bus->ppu->interrupt = None;
 }
+
+// Returns true once per frame, when the PPU enters vblank
+bool bus_poll_for_frame(Bus *bus) {
+    bool complete = bus->ppu->frame_complete;
+    bus->ppu->frame_complete = false;
+    return complete;
+}
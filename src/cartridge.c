@@ -1,52 +1,110 @@
 #include "../lib/cartridge.h"
+#include "../lib/mapper.h"
+#include "../lib/rom_cache.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Windows has no mmap(), ROM files are read into memory there instead
+#if defined(_WIN32) && !defined(ROM_READ_FILES)
+#define ROM_READ_FILES
+#endif
+#if !defined(ROM_READ_FILES)
+#include <sys/mman.h>
+#endif
+// Only Windows tells text from binary files
+#if !defined(O_BINARY)
+#define O_BINARY 0
+#endif
 
 uint8_t const NES_TAG[TAG_LENGTH] = {0x4E, 0x45, 0x53, 0x1A};
 
-ROM *get_rom(char *file_path) {
-    // Checks if file is a '.nes' file
-    char *file_extension = strrchr(file_path, '.');
-    if (strcmp(file_extension, ".nes") != 0) {
-        fprintf(stderr, "Error: specified file isn't '.nes' file.\n");
-        return NULL;
+// Returns the size of a NES 2.0 PRG or CHR ROM, whose low byte is 'lsb' and high nibble 'msb'
+static uint64_t nes2_rom_size(uint8_t lsb, uint8_t msb, int page_size) {
+    if (msb == 0x0F) {
+        // Exponent-multiplier notation, for sizes that aren't a multiple of the page size
+        int exponent = lsb >> 2;
+        int multiplier = (lsb & 0b11) * 2 + 1;
+        return exponent < 48 ? ((uint64_t) 1 << exponent) * multiplier : UINT64_MAX;
     }
+    return ((uint64_t) msb << 8 | lsb) * page_size;
+}
 
-    FILE *file = fopen(file_path, "rb");
-    if (file == NULL) {
-        fprintf(stderr, "Something went wrong when trying to open the file.\n");
-        fclose(file);
-        return NULL;
-    }
+// Returns the size of a NES 2.0 RAM area from its shift count
+static int nes2_ram_size(uint8_t shift) {
+    return shift > 0 ? 64 << shift : 0;
+}
 
+// Builds a ROM pointing into the iNES or NES 2.0 file 'image' of 'size' bytes
+// Returns NULL if the file is malformed, 'image' still belongs to the caller then
+// The mapper isn't checked, the ROM database may still correct it
+static ROM *rom_from_image(uint8_t *image, size_t size) {
     // Checks if file has the proper NES signature
-    uint8_t header[16];
-    fread(header, sizeof(uint8_t), 16, file);
-    if (!check_header(header)) {
+    if (size < HEADER_LENGTH || !check_header(image)) {
         fprintf(stderr, "Error: file isn't a '.nes' file of supported iNES type.\n");
-        fclose(file);
         return NULL;
     }
-    
-    ROM *rom = malloc(sizeof(ROM));
-    rom->prg_rom_length = header[PRG_ROM_LENGTH_ADDR] * PRG_ROM_PAGE_SIZE;
-    rom->chr_rom_length = header[CHR_ROM_LENGTH_ADDR] * CHR_ROM_PAGE_SIZE;
+    uint8_t *header = image;
     uint8_t control_byte_1 = header[CONTROL_BYTE_1_ADDR];
     uint8_t control_byte_2 = header[CONTROL_BYTE_2_ADDR];
-    //uint8_t prg_ram_length = header[PRG_RAM_LENGTH_ADDR]; IMPLEMENT LATER
-    
-    if ((control_byte_2 & 0b00001111) != 0) {
-        fprintf(stderr, "Warning: file isn't in the iNES 1.0 format.\n");
-        //free(rom);
-        //fclose(file);
-        //return NULL;
-    }
-    
+    bool nes2 = (control_byte_2 & FORMAT_BITS) == NES2_FORMAT;
+
+    // PRG and CHR ROM follow the header and the trainer, if there is one
+    size_t prg_start = HEADER_LENGTH;
+    if (control_byte_1 & 0b100) {
+        prg_start += TRAINER_LENGTH;
+    }
+    uint64_t prg_rom_length = header[PRG_ROM_LENGTH_ADDR] * PRG_ROM_PAGE_SIZE;
+    uint64_t chr_rom_length = header[CHR_ROM_LENGTH_ADDR] * CHR_ROM_PAGE_SIZE;
+    if (nes2) {
+        prg_rom_length = nes2_rom_size(header[PRG_ROM_LENGTH_ADDR], header[ROM_SIZE_MSB_ADDR] & 0x0F, PRG_ROM_PAGE_SIZE);
+        chr_rom_length = nes2_rom_size(header[CHR_ROM_LENGTH_ADDR], header[ROM_SIZE_MSB_ADDR] >> 4, CHR_ROM_PAGE_SIZE);
+    }
+    if (prg_rom_length > size || chr_rom_length > size || size < prg_start + prg_rom_length + chr_rom_length) {
+        fprintf(stderr, "Error: file is shorter than its header says.\n");
+        return NULL;
+    }
+
+    ROM *rom = malloc(sizeof(ROM));
+    if (rom == NULL) {
+        return NULL;
+    }
+    rom->prg_rom = image + prg_start;
+    rom->prg_rom_length = prg_rom_length;
+    // Carts without CHR ROM have CHR RAM instead, which comes with the mapper
+    rom->chr_rom = chr_rom_length > 0 ? image + prg_start + prg_rom_length : NULL;
+    rom->chr_rom_length = chr_rom_length;
     rom->mapper = (control_byte_2 & 0b11110000) | (control_byte_1 >> 4);
+    rom->battery = control_byte_1 & 0b10;
+    rom->nes2 = nes2;
+    rom->verified = false;
+
+    if (nes2) {
+        rom->mapper |= (header[MAPPER_MSB_ADDR] & 0x0F) << 8;
+        rom->submapper = header[MAPPER_MSB_ADDR] >> 4;
+        rom->prg_ram_length = nes2_ram_size(header[PRG_RAM_SHIFT_ADDR] & 0x0F);
+        rom->prg_nvram_length = nes2_ram_size(header[PRG_RAM_SHIFT_ADDR] >> 4);
+        rom->chr_ram_length = nes2_ram_size(header[CHR_RAM_SHIFT_ADDR] & 0x0F);
+        rom->chr_nvram_length = nes2_ram_size(header[CHR_RAM_SHIFT_ADDR] >> 4);
+        rom->timing = header[TIMING_ADDR] & 0b11;
+    }
+    else {
+        // iNES 1.0 only has the PRG RAM size, which the battery keeps whole or not at all
+        int prg_ram_pages = header[PRG_RAM_LENGTH_ADDR];
+        int prg_ram_length = (prg_ram_pages > 0 ? prg_ram_pages : 1) * PRG_RAM_PAGE_SIZE;
+        rom->submapper = 0;
+        rom->prg_ram_length = rom->battery ? 0 : prg_ram_length;
+        rom->prg_nvram_length = rom->battery ? prg_ram_length : 0;
+        rom->chr_ram_length = chr_rom_length == 0 ? CHR_RAM_DEFAULT_SIZE : 0;
+        rom->chr_nvram_length = 0;
+        rom->timing = NTSC;
+    }
 
     // Determine mirroring type
     if ((control_byte_1 & 0b1000) != 0) {
@@ -59,23 +117,135 @@ ROM *get_rom(char *file_path) {
         rom->mirroring = Horizontal;
     }
 
-    // Checks if trainer is present and skips it if it is
-    bool trainer = control_byte_1 & 0b100;
-    if (trainer) {
-        fseek(file, TRAINER_LENGTH, SEEK_CUR);
+    rom->image = image;
+    rom->image_size = size;
+    atomic_init(&rom->shares, 0);
+    return rom;
+}
+
+#if defined(ROM_READ_FILES)
+// Reads the whole file at 'file' into memory
+static uint8_t *map_image(int file, size_t size) {
+    uint8_t *image = malloc(size);
+    if (image == NULL) {
+        fprintf(stderr, "Couldn't allocate memory for the file.\n");
+        return NULL;
     }
+    for (size_t done = 0; done < size;) {
+        int count = read(file, image + done, size - done);
+        if (count <= 0) {
+            fprintf(stderr, "Something went wrong when trying to read the file.\n");
+            free(image);
+            return NULL;
+        }
+        done += count;
+    }
+    return image;
+}
 
-    // Reads PRG and CHR ROM into the ROM struct
-    rom->prg_rom = malloc(sizeof(uint8_t) * rom->prg_rom_length);
-    rom->chr_rom = malloc(sizeof(uint8_t) * rom->chr_rom_length);
-    
-    fread(rom->prg_rom, sizeof(uint8_t), rom->prg_rom_length, file);
-    fread(rom->chr_rom, sizeof(uint8_t), rom->chr_rom_length, file);
+static void unmap_image(uint8_t *image, size_t size) {
+    (void) size;
+    free(image);
+}
+#else
+// Maps the file at 'file' read-only, nothing is copied
+static uint8_t *map_image(int file, size_t size) {
+    uint8_t *image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (image == MAP_FAILED) {
+        fprintf(stderr, "Something went wrong when trying to map the file.\n");
+        return NULL;
+    }
+    return image;
+}
+
+static void unmap_image(uint8_t *image, size_t size) {
+    munmap(image, size);
+}
+#endif
 
-    fclose(file);
+// Builds a ROM from the file at 'file', see map_image()
+static ROM *map_rom(int file, const struct stat *info) {
+    size_t size = info->st_size;
+    uint8_t *image = map_image(file, size);
+    if (image == NULL) {
+        return NULL;
+    }
+    ROM *rom = rom_from_image(image, size);
+    if (rom == NULL) {
+        unmap_image(image, size);
+    }
     return rom;
 }
 
+// Loads a ROM through the ROM cache, files loaded before and files with the same PRG and CHR share one ROM
+// The ROM is freed by free_rom() once every owner released it
+ROM *get_rom(char *file_path) {
+    // Checks if file is a '.nes' file
+    char *file_extension = strrchr(file_path, '.');
+    if (file_extension == NULL || strcmp(file_extension, ".nes") != 0) {
+        fprintf(stderr, "Error: specified file isn't '.nes' file.\n");
+        return NULL;
+    }
+
+    int file = open(file_path, O_RDONLY | O_BINARY);
+    if (file < 0) {
+        fprintf(stderr, "Something went wrong when trying to open the file.\n");
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size < HEADER_LENGTH) {
+        fprintf(stderr, "Error: file isn't a '.nes' file of supported iNES type.\n");
+        close(file);
+        return NULL;
+    }
+
+    // Unchanged files are only stat'ed, the mapping outlives the descriptor
+    ROM *rom = rom_cache_find_file(file_path, &info);
+    if (rom == NULL) {
+        rom = map_rom(file, &info);
+        if (rom != NULL) {
+            rom = rom_cache_add(rom, file_path, &info);
+        }
+    }
+    close(file);
+    if (rom == NULL) {
+        return NULL;
+    }
+
+    // Headers the database corrected are trusted
+    if (!rom->verified && !rom->nes2 && (rom->image[CONTROL_BYTE_2_ADDR] & FORMAT_BITS) != 0) {
+        fprintf(stderr, "Warning: file isn't in the iNES 1.0 or NES 2.0 format.\n");
+    }
+    if (!mapper_supported(rom->mapper)) {
+        fprintf(stderr, "Error: mapper %i isn't supported.\n", rom->mapper);
+        free_rom(rom);
+        return NULL;
+    }
+    return rom;
+}
+
+// Adds an owner to 'rom', which is released with free_rom()
+// Safe to call from any thread
+ROM *rom_retain(ROM *rom) {
+    atomic_fetch_add(&rom->shares, 1);
+    return rom;
+}
+
+// Releases an owner of 'rom', the last one frees it
+void free_rom(ROM *rom) {
+    if (atomic_fetch_sub(&rom->shares, 1) > 0) {
+        return;
+    }
+    if (rom->image != NULL) {
+        unmap_image(rom->image, rom->image_size);
+    }
+    else {
+        free(rom->prg_rom);
+        free(rom->chr_rom);
+    }
+    free(rom);
+}
+
 bool check_header(uint8_t *header) {
     for (int i = 0; i < TAG_LENGTH; i++) {
         if (header[i] != NES_TAG[i]) {
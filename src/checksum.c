@@ -0,0 +1,125 @@
+#include "../lib/checksum.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// CRC-32 as used by zip and ROM databases, reflected polynomial 0xEDB88320
+// Works a nibble at a time, which keeps the table small
+static const uint32_t CRC32_NIBBLES[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crc32_bytes(const uint8_t *bytes, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ CRC32_NIBBLES[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLES[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static uint32_t rotate_left(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// Mixes one 64 byte block into 'state'
+static void sha1_block(uint32_t state[5], const uint8_t *block) {
+    uint32_t words[80];
+    for (int i = 0; i < 16; i++) {
+        words[i] = (uint32_t) block[i * 4] << 24 | block[i * 4 + 1] << 16 | block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        words[i] = rotate_left(words[i - 3] ^ words[i - 8] ^ words[i - 14] ^ words[i - 16], 1);
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = rotate_left(a, 5) + f + e + k + words[i];
+        e = d;
+        d = c;
+        c = rotate_left(b, 30);
+        b = a;
+        a = temp;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+void sha1_bytes(const uint8_t *bytes, size_t length, uint8_t digest[SHA1_LENGTH]) {
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t whole = length - length % 64;
+    for (size_t i = 0; i < whole; i += 64) {
+        sha1_block(state, bytes + i);
+    }
+
+    // The rest of the input, a 1 bit and the length in bits fill one or two more blocks
+    uint8_t tail[128] = {0};
+    size_t rest = length - whole;
+    memcpy(tail, bytes + whole, rest);
+    tail[rest] = 0x80;
+    size_t tail_length = rest < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t) length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_length - 1 - i] = bits >> (i * 8);
+    }
+    for (size_t i = 0; i < tail_length; i += 64) {
+        sha1_block(state, tail + i);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = state[i] >> 24;
+        digest[i * 4 + 1] = state[i] >> 16;
+        digest[i * 4 + 2] = state[i] >> 8;
+        digest[i * 4 + 3] = state[i];
+    }
+}
+
+void sha1_to_string(const uint8_t digest[SHA1_LENGTH], char string[SHA1_STRING_LENGTH]) {
+    for (int i = 0; i < SHA1_LENGTH; i++) {
+        sprintf(string + i * 2, "%02x", digest[i]);
+    }
+}
+
+// Returns false if 'string' isn't 40 hex digits
+bool sha1_from_string(const char *string, uint8_t digest[SHA1_LENGTH]) {
+    if (strlen(string) != SHA1_LENGTH * 2) {
+        return false;
+    }
+    for (int i = 0; i < SHA1_LENGTH; i++) {
+        unsigned int byte;
+        if (sscanf(string + i * 2, "%2x", &byte) != 1) {
+            return false;
+        }
+        digest[i] = byte;
+    }
+    return true;
+}
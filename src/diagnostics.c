@@ -0,0 +1,82 @@
+#include "../lib/diagnostics.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static const char *EVENT_NAMES[DIAGNOSTIC_EVENTS] = {
+    "reads from write-only registers",
+    "reads from unmapped addresses",
+    "writes to read-only registers",
+    "writes to PRG ROM",
+    "writes to unmapped addresses",
+};
+
+Diagnostics diagnostics_new(int verbosity) {
+    Diagnostics diagnostics;
+    diagnostics.verbosity = verbosity;
+    diagnostics.frames_since_report = 0;
+    memset(diagnostics.totals, 0, sizeof(diagnostics.totals));
+    memset(diagnostics.pending, 0, sizeof(diagnostics.pending));
+    diagnostics.address_counts = NULL;
+    return diagnostics;
+}
+
+void diagnostics_destroy(Diagnostics *diagnostics) {
+    free(diagnostics->address_counts);
+    diagnostics->address_counts = NULL;
+}
+
+// Counts an access, never prints anything
+void diagnostics_record(Diagnostics *diagnostics, DiagnosticEvent event, uint16_t addr) {
+    diagnostics->totals[event]++;
+    diagnostics->pending[event]++;
+    // Only verbosity 2 reports addresses, the table is too big to keep for nothing
+    if (diagnostics->verbosity < 2) {
+        return;
+    }
+    if (diagnostics->address_counts == NULL) {
+        diagnostics->address_counts = calloc(DIAGNOSTIC_EVENTS * DIAGNOSTIC_ADDRESSES, sizeof(uint32_t));
+        if (diagnostics->address_counts == NULL) {
+            return;
+        }
+    }
+    diagnostics->address_counts[event * DIAGNOSTIC_ADDRESSES + addr]++;
+}
+
+// Reports at most once every DIAGNOSTICS_REPORT_INTERVAL frames
+void diagnostics_end_frame(Diagnostics *diagnostics) {
+    diagnostics->frames_since_report++;
+    if (diagnostics->frames_since_report < DIAGNOSTICS_REPORT_INTERVAL) {
+        return;
+    }
+    if (diagnostics->verbosity > 0) {
+        diagnostics_report(diagnostics, stderr);
+    }
+    diagnostics->frames_since_report = 0;
+}
+
+// Prints what happened since the last report and starts counting again
+void diagnostics_report(Diagnostics *diagnostics, FILE *stream) {
+    for (int event = 0; event < DIAGNOSTIC_EVENTS; event++) {
+        if (diagnostics->pending[event] == 0) {
+            continue;
+        }
+        fprintf(stream, "%u %s (%llu in total).\n", diagnostics->pending[event], EVENT_NAMES[event], (unsigned long long) diagnostics->totals[event]);
+        diagnostics->pending[event] = 0;
+        if (diagnostics->address_counts == NULL) {
+            continue;
+        }
+
+        uint32_t *counts = diagnostics->address_counts + event * DIAGNOSTIC_ADDRESSES;
+        if (diagnostics->verbosity >= 2) {
+            for (int addr = 0; addr < DIAGNOSTIC_ADDRESSES; addr++) {
+                if (counts[addr] != 0) {
+                    fprintf(stream, "    %04X: %u\n", addr, counts[addr]);
+                }
+            }
+        }
+        memset(counts, 0, DIAGNOSTIC_ADDRESSES * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,93 @@
+#include "../lib/frontend.h"
+#include "../lib/nes.h"
+#include "../lib/bus.h"
+#include "../lib/io.h"
+#include "../lib/joypad.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+// Runs one frame at a time
+// Input, presentation and pacing only happen between frames
+void run(NES *nes, SDL_Renderer *renderer, SDL_Texture *texture) {
+    SDL_Event event;
+    uint64_t frame_ticks = SDL_GetPerformanceFrequency() / FRAMES_PER_SECOND;
+    uint64_t next_frame = SDL_GetPerformanceCounter() + frame_ticks;
+    // The frame is only converted to RGB here, right before being presented
+    uint32_t *pixels = malloc(sizeof(uint32_t) * FRAME_PIXELS);
+    if (pixels == NULL) {
+        return;
+    }
+
+    while (nes_run_frame(nes)) {
+        // Skipped frames aren't converted or presented either
+        if (nes_frame_drawn(nes)) {
+            frame_to_xrgb8888(nes->frame, pixels);
+            SDL_RenderClear(renderer);
+            SDL_UpdateTexture(texture, NULL, pixels, FRAME_WIDTH * sizeof(uint32_t));
+            SDL_RenderCopy(renderer, texture, NULL, NULL);
+            SDL_RenderPresent(renderer);
+        }
+
+        if (handle_input(&nes->bus->joypad_1, &event)) {
+            break;
+        }
+        bool fast_forward = SDL_GetKeyboardState(NULL)[SDL_SCANCODE_TAB];
+        nes_set_frame_skip(nes, fast_forward ? FAST_FORWARD_PERIOD - 1 : 0, FAST_FORWARD_PERIOD);
+
+        uint64_t now = SDL_GetPerformanceCounter();
+        if (fast_forward) {
+            next_frame = now + frame_ticks;
+        }
+        else if (now < next_frame) {
+            SDL_Delay((next_frame - now) * 1000 / SDL_GetPerformanceFrequency());
+            next_frame += frame_ticks;
+        }
+        else {
+            // Running behind, don't try to catch up
+            next_frame = now + frame_ticks;
+        }
+    }
+    free(pixels);
+}
+
+// Maps a key to the joypad button it controls
+static uint8_t key_to_button(SDL_Keycode key) {
+    switch (key) {
+        case SDLK_UP: return JOYPAD_UP;
+        case SDLK_DOWN: return JOYPAD_DOWN;
+        case SDLK_LEFT: return JOYPAD_LEFT;
+        case SDLK_RIGHT: return JOYPAD_RIGHT;
+        case SDLK_a: return JOYPAD_A;
+        case SDLK_s: return JOYPAD_B;
+        case SDLK_SPACE: return JOYPAD_SELECT;
+        case SDLK_RETURN: return JOYPAD_START;
+        default: return 0;
+    }
+}
+
+// Drains the event queue and latches the keys into the joypad
+// Meant to be called once per frame
+// Returns true if program should stop
+bool handle_input(Joypad *joypad, SDL_Event *event) {
+    while (SDL_PollEvent(event)) {
+        switch (event->type) {
+            case SDL_QUIT:
+                return true;
+            case SDL_KEYDOWN:
+                if (event->key.keysym.sym == SDLK_ESCAPE) {
+                    return true;
+                }
+                joypad_button_set(joypad, key_to_button(event->key.keysym.sym), true);
+                break;
+            case SDL_KEYUP:
+                joypad_button_set(joypad, key_to_button(event->key.keysym.sym), false);
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,99 @@
+#include "../lib/headless.h"
+#include "../lib/nes.h"
+#include "../lib/bus.h"
+#include "../lib/io.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+HeadlessOptions headless_options_new(void) {
+    HeadlessOptions options;
+    options.frames = 0;
+    options.until_addr = -1;
+    options.until_value = 0;
+    options.dump_dir = NULL;
+    options.print_hashes = false;
+    options.skip_frames = 0;
+    options.skip_period = 1;
+    return options;
+}
+
+// Runs frames back to back with no pacing or presentation
+HeadlessResult run_headless(NES *nes, HeadlessOptions *options) {
+    HeadlessResult result = {0, false, false, 0.0};
+    clock_t start = clock();
+    nes_set_frame_skip(nes, options->skip_frames, options->skip_period);
+
+    while (options->frames == 0 || result.frames < options->frames) {
+        if (!nes_run_frame(nes)) {
+            result.stopped = true;
+            break;
+        }
+        result.frames++;
+
+        if (options->print_hashes && nes_frame_drawn(nes)) {
+            printf("%i %016llX\n", result.frames, (unsigned long long) hash_frame(nes->frame));
+        }
+        if (options->dump_dir != NULL && nes_frame_drawn(nes)) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frame_%06i.ppm", options->dump_dir, result.frames);
+            if (!write_frame_ppm(path, nes->frame)) {
+                fprintf(stderr, "Couldn't write frame to '%s'.\n", path);
+            }
+        }
+        // RAM is read straight from the bus, register reads would change the run being checked
+        if (options->until_addr >= 0 && nes->bus->ram[options->until_addr % sizeof(nes->bus->ram)] == options->until_value) {
+            result.condition_met = true;
+            break;
+        }
+    }
+
+    result.seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    return result;
+}
+
+// Hashing and dumping functions
+
+// 64-bit FNV-1a
+uint64_t hash_bytes(const uint8_t *bytes, int length) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (int i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hash_frame(const uint8_t *frame) {
+    return hash_bytes(frame, FRAME_SIZE);
+}
+
+uint64_t hash_ram(NES *nes) {
+    return hash_bytes(nes->bus->ram, sizeof(nes->bus->ram));
+}
+
+// Writes a frame as a binary PPM image
+bool write_frame_ppm(const char *path, const uint8_t *frame) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    size_t length = FRAME_PIXELS * 3;
+    uint8_t *rgb = malloc(length);
+    if (rgb == NULL) {
+        fclose(file);
+        return false;
+    }
+    frame_to_rgb24(frame, rgb);
+    fprintf(file, "P6\n%i %i\n255\n", FRAME_WIDTH, FRAME_HEIGHT);
+    bool success = fwrite(rgb, sizeof(uint8_t), length, file) == length;
+    free(rgb);
+    fclose(file);
+    return success;
+}
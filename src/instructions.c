@@ -5,395 +5,396 @@
 #include <stdint.h>
 #include <stdio.h>
 
-Instruction inst_list[0x100];
-
-void populate_inst_list(void) {
-    for (int i = 0x00; i < 0x100; i++) {
-        inst_list[i] = get_instruction_from_opcode(i);
-    }
-}
-
-Instruction get_instruction_from_opcode(uint8_t opcode) {
-    Instruction inst;
-    switch (opcode) {
-        // opcode, mnemonic, bytes, cycles, mode
-        // In alphabetical order of mnemonics
-        // Some are grouped by functionality, but that is just an alphabetical coincidence
-        case 0x69: inst = (Instruction) {0x69, "ADC\0", 2, 2, Immediate}; return inst;
-        case 0x65: inst = (Instruction) {0x65, "ADC\0", 2, 3, ZeroPage}; return inst;
-        case 0x75: inst = (Instruction) {0x75, "ADC\0", 2, 4, ZeroPageX}; return inst;
-        case 0x6D: inst = (Instruction) {0x6D, "ADC\0", 3, 4, Absolute}; return inst;
-        case 0x7D: inst = (Instruction) {0x7D, "ADC\0", 3, 4, AbsoluteX}; return inst;
-        case 0x79: inst = (Instruction) {0x79, "ADC\0", 3, 4, AbsoluteY}; return inst;
-        case 0x61: inst = (Instruction) {0x61, "ADC\0", 2, 6, IndirectX}; return inst;
-        case 0x71: inst = (Instruction) {0x71, "ADC\0", 2, 5, IndirectY}; return inst;
-
-        case 0x29: inst = (Instruction) {0x29, "AND\0", 2, 2, Immediate}; return inst;
-        case 0x25: inst = (Instruction) {0x25, "AND\0", 2, 3, ZeroPage}; return inst;
-        case 0x35: inst = (Instruction) {0x35, "AND\0", 2, 4, ZeroPageX}; return inst;
-        case 0x2D: inst = (Instruction) {0x2D, "AND\0", 3, 4, Absolute}; return inst;
-        case 0x3D: inst = (Instruction) {0x3D, "AND\0", 3, 4, AbsoluteX}; return inst;
-        case 0x39: inst = (Instruction) {0x39, "AND\0", 3, 4, AbsoluteY}; return inst;
-        case 0x21: inst = (Instruction) {0x21, "AND\0", 2, 6, IndirectX}; return inst;
-        case 0x31: inst = (Instruction) {0x31, "AND\0", 2, 5, IndirectY}; return inst;
-
-        case 0x0A: inst = (Instruction) {0x0A, "ASL\0", 1, 2, Implied}; return inst;
-        case 0x06: inst = (Instruction) {0x06, "ASL\0", 2, 5, ZeroPage}; return inst;
-        case 0x16: inst = (Instruction) {0x16, "ASL\0", 2, 6, ZeroPageX}; return inst;
-        case 0x0E: inst = (Instruction) {0x0E, "ASL\0", 3, 6, Absolute}; return inst;
-        case 0x1E: inst = (Instruction) {0x1E, "ASL\0", 3, 7, AbsoluteX}; return inst;
-
-        // Branch instructions part 1
-        case 0x90: inst = (Instruction) {0x90, "BCC\0", 2, 2, Relative}; return inst;
-        case 0xB0: inst = (Instruction) {0xB0, "BCS\0", 2, 2, Relative}; return inst;
-        case 0xF0: inst = (Instruction) {0xF0, "BEQ\0", 2, 2, Relative}; return inst;
-
-        case 0x24: inst = (Instruction) {0x24, "BIT\0", 2, 3, ZeroPage}; return inst;
-        case 0x2C: inst = (Instruction) {0x2C, "BIT\0", 3, 4, Absolute}; return inst;
-
-        // Branch instructions part 2
-        case 0x30: inst = (Instruction) {0x30, "BMI\0", 2, 2, Relative}; return inst;
-        case 0xD0: inst = (Instruction) {0xD0, "BNE\0", 2, 2, Relative}; return inst;
-        case 0x10: inst = (Instruction) {0x10, "BPL\0", 2, 2, Relative}; return inst;
-
-        case 0x00: inst = (Instruction) {0x00, "BRK\0", 1, 7, Implied}; return inst;
-
-        // Branch instructions part 3
-        case 0x50: inst = (Instruction) {0x50, "BVC\0", 2, 2, Relative}; return inst;
-        case 0x70: inst = (Instruction) {0x70, "BVS\0", 2, 2, Relative}; return inst;
-
-        // Clear instructions
-        case 0x18: inst = (Instruction) {0x18, "CLC\0", 1, 2, Implied}; return inst;
-        case 0xD8: inst = (Instruction) {0xD8, "CLD\0", 1, 2, Implied}; return inst;
-        case 0x58: inst = (Instruction) {0x58, "CLI\0", 1, 2, Implied}; return inst;
-        case 0xB8: inst = (Instruction) {0xB8, "CLV\0", 1, 2, Implied}; return inst;
-
-        // Compare instructions
-        case 0xC9: inst = (Instruction) {0xC9, "CMP\0", 2, 2, Immediate}; return inst;
-        case 0xC5: inst = (Instruction) {0xC5, "CMP\0", 2, 3, ZeroPage}; return inst;
-        case 0xD5: inst = (Instruction) {0xD5, "CMP\0", 2, 4, ZeroPageX}; return inst;
-        case 0xCD: inst = (Instruction) {0xCD, "CMP\0", 3, 4, Absolute}; return inst;
-        case 0xDD: inst = (Instruction) {0xDD, "CMP\0", 3, 4, AbsoluteX}; return inst;
-        case 0xD9: inst = (Instruction) {0xD9, "CMP\0", 3, 4, AbsoluteY}; return inst;
-        case 0xC1: inst = (Instruction) {0xC1, "CMP\0", 2, 6, IndirectX}; return inst;
-        case 0xD1: inst = (Instruction) {0xD1, "CMP\0", 2, 5, IndirectY}; return inst;
-
-        case 0xE0: inst = (Instruction) {0xE0, "CPX\0", 2, 2, Immediate}; return inst;
-        case 0xE4: inst = (Instruction) {0xE4, "CPX\0", 2, 3, ZeroPage}; return inst;
-        case 0xEC: inst = (Instruction) {0xEC, "CPX\0", 3, 4, Absolute}; return inst;
-
-        case 0xC0: inst = (Instruction) {0xC0, "CPY\0", 2, 2, Immediate}; return inst;
-        case 0xC4: inst = (Instruction) {0xC4, "CPY\0", 2, 3, ZeroPage}; return inst;
-        case 0xCC: inst = (Instruction) {0xCC, "CPY\0", 3, 4, Absolute}; return inst;
-
-        // Decrement instructions
-        case 0xC6: inst = (Instruction) {0xC6, "DEC\0", 2, 5, ZeroPage}; return inst;
-        case 0xD6: inst = (Instruction) {0xD6, "DEC\0", 2, 6, ZeroPageX}; return inst;
-        case 0xCE: inst = (Instruction) {0xCE, "DEC\0", 3, 6, Absolute}; return inst;
-        case 0xDE: inst = (Instruction) {0xDE, "DEC\0", 3, 7, AbsoluteX}; return inst;
-
-        case 0xCA: inst = (Instruction) {0xCA, "DEX\0", 1, 2, Implied}; return inst;
-        case 0x88: inst = (Instruction) {0x88, "DEY\0", 1, 2, Implied}; return inst;
-
-        case 0x49: inst = (Instruction) {0x49, "EOR\0", 2, 2, Immediate}; return inst;
-        case 0x45: inst = (Instruction) {0x45, "EOR\0", 2, 3, ZeroPage}; return inst;
-        case 0x55: inst = (Instruction) {0x55, "EOR\0", 2, 4, ZeroPageX}; return inst;
-        case 0x4D: inst = (Instruction) {0x4D, "EOR\0", 3, 4, Absolute}; return inst;
-        case 0x5D: inst = (Instruction) {0x5D, "EOR\0", 3, 4, AbsoluteX}; return inst;
-        case 0x59: inst = (Instruction) {0x59, "EOR\0", 3, 4, AbsoluteY}; return inst;
-        case 0x41: inst = (Instruction) {0x41, "EOR\0", 2, 6, IndirectX}; return inst;
-        case 0x51: inst = (Instruction) {0x51, "EOR\0", 2, 5, IndirectY}; return inst;
-
-        // Increment instructions
-        case 0xE6: inst = (Instruction) {0xE6, "INC\0", 2, 5, ZeroPage}; return inst;
-        case 0xF6: inst = (Instruction) {0xF6, "INC\0", 2, 6, ZeroPageX}; return inst;
-        case 0xEE: inst = (Instruction) {0xEE, "INC\0", 3, 6, Absolute}; return inst;
-        case 0xFE: inst = (Instruction) {0xFE, "INC\0", 3, 7, AbsoluteX}; return inst;
-
-        case 0xE8: inst = (Instruction) {0xE8, "INX\0", 1, 2, Implied}; return inst;
-
-        case 0xC8: inst = (Instruction) {0xC8, "INY\0", 1, 2, Implied}; return inst;
-
-        // Jump instructions
-        case 0x4C: inst = (Instruction) {0x4C, "JMP\0", 3, 3, Absolute}; return inst;
-        case 0x6C: inst = (Instruction) {0x6C, "JMP\0", 3, 5, Indirect}; return inst;
-
-        case 0x20: inst = (Instruction) {0x20, "JSR\0", 3, 6, Absolute}; return inst;
-
-        // Load instructions
-        case 0xA9: inst = (Instruction) {0xA9, "LDA\0", 2, 2, Immediate}; return inst;
-        case 0xA5: inst = (Instruction) {0xA5, "LDA\0", 2, 3, ZeroPage}; return inst;
-        case 0xB5: inst = (Instruction) {0xB5, "LDA\0", 2, 4, ZeroPageX}; return inst;
-        case 0xAD: inst = (Instruction) {0xAD, "LDA\0", 3, 4, Absolute}; return inst;
-        case 0xBD: inst = (Instruction) {0xBD, "LDA\0", 3, 4, AbsoluteX}; return inst;
-        case 0xB9: inst = (Instruction) {0xB9, "LDA\0", 3, 4, AbsoluteY}; return inst;
-        case 0xA1: inst = (Instruction) {0xA1, "LDA\0", 2, 6, IndirectX}; return inst;
-        case 0xB1: inst = (Instruction) {0xB1, "LDA\0", 2, 5, IndirectY}; return inst;
-
-        case 0xA2: inst = (Instruction) {0xA2, "LDX\0", 2, 2, Immediate}; return inst;
-        case 0xA6: inst = (Instruction) {0xA6, "LDX\0", 2, 3, ZeroPage}; return inst;
-        case 0xB6: inst = (Instruction) {0xB6, "LDX\0", 2, 4, ZeroPageY}; return inst;
-        case 0xAE: inst = (Instruction) {0xAE, "LDX\0", 3, 4, Absolute}; return inst;
-        case 0xBE: inst = (Instruction) {0xBE, "LDX\0", 3, 4, AbsoluteY}; return inst;
-
-        case 0xA0: inst = (Instruction) {0xA0, "LDY\0", 2, 2, Immediate}; return inst;
-        case 0xA4: inst = (Instruction) {0xA4, "LDY\0", 2, 3, ZeroPage}; return inst;
-        case 0xB4: inst = (Instruction) {0xB4, "LDY\0", 2, 4, ZeroPageX}; return inst;
-        case 0xAC: inst = (Instruction) {0xAC, "LDY\0", 3, 4, Absolute}; return inst;
-        case 0xBC: inst = (Instruction) {0xBC, "LDY\0", 3, 4, AbsoluteX}; return inst;
-
-        case 0x4A: inst = (Instruction) {0x4A, "LSR\0", 1, 2, Implied}; return inst;
-        case 0x46: inst = (Instruction) {0x46, "LSR\0", 2, 5, ZeroPage}; return inst;
-        case 0x56: inst = (Instruction) {0x56, "LSR\0", 2, 6, ZeroPageX}; return inst;
-        case 0x4E: inst = (Instruction) {0x4E, "LSR\0", 3, 6, Absolute}; return inst;
-        case 0x5E: inst = (Instruction) {0x5E, "LSR\0", 3, 7, AbsoluteX}; return inst;
-
-        case 0xEA: inst = (Instruction) {0xEA, "NOP\0", 1, 2, Implied}; return inst;
-
-        case 0x09: inst = (Instruction) {0x09, "ORA\0", 2, 2, Immediate}; return inst;
-        case 0x05: inst = (Instruction) {0x05, "ORA\0", 2, 3, ZeroPage}; return inst;
-        case 0x15: inst = (Instruction) {0x15, "ORA\0", 2, 4, ZeroPageX}; return inst;
-        case 0x0D: inst = (Instruction) {0x0D, "ORA\0", 3, 4, Absolute}; return inst;
-        case 0x1D: inst = (Instruction) {0x1D, "ORA\0", 3, 4, AbsoluteX}; return inst;
-        case 0x19: inst = (Instruction) {0x19, "ORA\0", 3, 4, AbsoluteY}; return inst;
-        case 0x01: inst = (Instruction) {0x01, "ORA\0", 2, 6, IndirectX}; return inst;
-        case 0x11: inst = (Instruction) {0x11, "ORA\0", 2, 5, IndirectY}; return inst;
-
-        // Push instructions
-        case 0x48: inst = (Instruction) {0x48, "PHA\0", 1, 3, Implied}; return inst;
-        case 0x08: inst = (Instruction) {0x08, "PHP\0", 1, 3, Implied}; return inst;
-
-        // Pull instructions
-        case 0x68: inst = (Instruction) {0x68, "PLA\0", 1, 4, Implied}; return inst;
-        case 0x28: inst = (Instruction) {0x28, "PLP\0", 1, 4, Implied}; return inst;
-
-        // Rotate instructions
-        case 0x2A: inst = (Instruction) {0x2A, "ROL\0", 1, 2, Implied}; return inst;
-        case 0x26: inst = (Instruction) {0x26, "ROL\0", 2, 5, ZeroPage}; return inst;
-        case 0x36: inst = (Instruction) {0x36, "ROL\0", 2, 6, ZeroPageX}; return inst;
-        case 0x2E: inst = (Instruction) {0x2E, "ROL\0", 3, 6, Absolute}; return inst;
-        case 0x3E: inst = (Instruction) {0x3E, "ROL\0", 3, 7, AbsoluteX}; return inst;
-
-        case 0x6A: inst = (Instruction) {0x6A, "ROR\0", 1, 2, Implied}; return inst;
-        case 0x66: inst = (Instruction) {0x66, "ROR\0", 2, 5, ZeroPage}; return inst;
-        case 0x76: inst = (Instruction) {0x76, "ROR\0", 2, 6, ZeroPageX}; return inst;
-        case 0x6E: inst = (Instruction) {0x6E, "ROR\0", 3, 6, Absolute}; return inst;
-        case 0x7E: inst = (Instruction) {0x7E, "ROR\0", 3, 7, AbsoluteX}; return inst;
-
-        // Return instructions
-        case 0x40: inst = (Instruction) {0x40, "RTI\0", 1, 6, Implied}; return inst;
-        case 0x60: inst = (Instruction) {0x60, "RTS\0", 1, 6, Implied}; return inst;
-
-        case 0xE9: inst = (Instruction) {0xE9, "SBC\0", 2, 2, Immediate}; return inst;
-        case 0xE5: inst = (Instruction) {0xE5, "SBC\0", 2, 3, ZeroPage}; return inst;
-        case 0xF5: inst = (Instruction) {0xF5, "SBC\0", 2, 4, ZeroPageX}; return inst;
-        case 0xED: inst = (Instruction) {0xED, "SBC\0", 3, 4, Absolute}; return inst;
-        case 0xFD: inst = (Instruction) {0xFD, "SBC\0", 3, 4, AbsoluteX}; return inst;
-        case 0xF9: inst = (Instruction) {0xF9, "SBC\0", 3, 4, AbsoluteY}; return inst;
-        case 0xE1: inst = (Instruction) {0xE1, "SBC\0", 2, 6, IndirectX}; return inst;
-        case 0xF1: inst = (Instruction) {0xF1, "SBC\0", 2, 5, IndirectY}; return inst;
-
-        // Set flag intructions
-        case 0x38: inst = (Instruction) {0x38, "SEC\0", 1, 2, Implied}; return inst;
-        case 0xF8: inst = (Instruction) {0xF8, "SED\0", 1, 2, Implied}; return inst;
-        case 0x78: inst = (Instruction) {0x78, "SEI\0", 1, 2, Implied}; return inst;
-
-        // Store instructions
-        case 0x85: inst = (Instruction) {0x85, "STA\0", 2, 3, ZeroPage}; return inst;
-        case 0x95: inst = (Instruction) {0x95, "STA\0", 2, 4, ZeroPageX}; return inst;
-        case 0x8D: inst = (Instruction) {0x8D, "STA\0", 3, 4, Absolute}; return inst;
-        case 0x9D: inst = (Instruction) {0x9D, "STA\0", 3, 5, AbsoluteX}; return inst;
-        case 0x99: inst = (Instruction) {0x99, "STA\0", 3, 5, AbsoluteY}; return inst;
-        case 0x81: inst = (Instruction) {0x81, "STA\0", 2, 6, IndirectX}; return inst;
-        case 0x91: inst = (Instruction) {0x91, "STA\0", 2, 6, IndirectY}; return inst;
-
-        case 0x86: inst = (Instruction) {0x86, "STX\0", 2, 3, ZeroPage}; return inst;
-        case 0x96: inst = (Instruction) {0x96, "STX\0", 2, 4, ZeroPageY}; return inst;
-        case 0x8E: inst = (Instruction) {0x8E, "STX\0", 3, 4, Absolute}; return inst;
-
-        case 0x84: inst = (Instruction) {0x84, "STY\0", 2, 3, ZeroPage}; return inst;
-        case 0x94: inst = (Instruction) {0x94, "STY\0", 2, 4, ZeroPageX}; return inst;
-        case 0x8C: inst = (Instruction) {0x8C, "STY\0", 3, 4, Absolute}; return inst;
-        
-        // Transfer instructions
-        case 0xAA: inst = (Instruction) {0xAA, "TAX\0", 1, 2, Implied}; return inst;
-        case 0xA8: inst = (Instruction) {0xA8, "TAY\0", 1, 2, Implied}; return inst;
-        case 0xBA: inst = (Instruction) {0xBA, "TSX\0", 1, 2, Implied}; return inst;
-        case 0x8A: inst = (Instruction) {0x8A, "TXA\0", 1, 2, Implied}; return inst;
-        case 0x9A: inst = (Instruction) {0x9A, "TXS\0", 1, 2, Implied}; return inst;
-        case 0x98: inst = (Instruction) {0x98, "TYA\0", 1, 2, Implied}; return inst;
-
-        // Unofficial opcodes
-
-        // ANC: AND with accumulator. Sets carry is result is negative.
-        case 0x0B: inst = (Instruction) {0x0B, "*ANC\0", 2, 2, Immediate}; return inst;
-        case 0x2B: inst = (Instruction) {0x2B, "*ANC\0", 2, 2, Immediate}; return inst;
-
-        // ARR: AND with accumulator then rotate accumulator one bit to the right
-        // Check bits 5 and 6:
-        // If both bits are 1: set C, clear V.
-        // If both bits are 0: clear C and V.
-        // If only bit 5 is 1: set V, clear C.
-        // If only bit 6 is 1: set C and V.
-        case 0x6B: inst = (Instruction) {0x6B, "*ARR\0", 2, 2, Immediate}; return inst;
-
-        // ASR: AND with accumulator then shift one bit to the right
-        case 0x4B: inst = (Instruction) {0x4B, "*ASR\0", 2, 2, Immediate}; return inst;
-
-        // DCP: Decrement memory and compare with accumulator
-        case 0xC7: inst = (Instruction) {0xC7, "*DCP\0", 2, 5, ZeroPage}; return inst;
-		case 0xD7: inst = (Instruction) {0xD7, "*DCP\0", 2, 6, ZeroPageX}; return inst;
-		case 0xCF: inst = (Instruction) {0xCF, "*DCP\0", 3, 6, Absolute}; return inst;
-		case 0xDF: inst = (Instruction) {0xDF, "*DCP\0", 3, 7, AbsoluteX}; return inst;
-		case 0xDB: inst = (Instruction) {0xDB, "*DCP\0", 3, 7, AbsoluteY}; return inst;
-		case 0xC3: inst = (Instruction) {0xC3, "*DCP\0", 2, 8, IndirectX}; return inst;
-		case 0xD3: inst = (Instruction) {0xD3, "*DCP\0", 2, 8, IndirectY}; return inst;
-
-        // DOP (NOP) -> Double NOP
-        case 0x80: inst = (Instruction) {0x80, "*NOP\0", 2, 2, Immediate}; return inst;
-		case 0x82: inst = (Instruction) {0x82, "*NOP\0", 2, 2, Immediate}; return inst;
-		case 0x89: inst = (Instruction) {0x89, "*NOP\0", 2, 2, Immediate}; return inst;
-		case 0xC2: inst = (Instruction) {0xC2, "*NOP\0", 2, 2, Immediate}; return inst;
-		case 0xE2: inst = (Instruction) {0xE2, "*NOP\0", 2, 2, Immediate}; return inst;
-        case 0x04: inst = (Instruction) {0x04, "*NOP\0", 2, 3, ZeroPage}; return inst;
-        case 0x44: inst = (Instruction) {0x44, "*NOP\0", 2, 3, ZeroPage}; return inst;
-        case 0x64: inst = (Instruction) {0x64, "*NOP\0", 2, 3, ZeroPage}; return inst;
-        case 0x14: inst = (Instruction) {0x14, "*NOP\0", 2, 4, ZeroPageX}; return inst;
-		case 0x34: inst = (Instruction) {0x34, "*NOP\0", 2, 4, ZeroPageX}; return inst;
-		case 0x54: inst = (Instruction) {0x54, "*NOP\0", 2, 4, ZeroPageX}; return inst;
-		case 0x74: inst = (Instruction) {0x74, "*NOP\0", 2, 4, ZeroPageX}; return inst;
-		case 0xD4: inst = (Instruction) {0xD4, "*NOP\0", 2, 4, ZeroPageX}; return inst;
-		case 0xF4: inst = (Instruction) {0xF4, "*NOP\0", 2, 4, ZeroPageX}; return inst;
-
-        // ISB: Increment memory then subtract it from accumulator
-        case 0xE7: inst = (Instruction) {0xE7, "*ISB\0", 2, 5, ZeroPage}; return inst;
-		case 0xF7: inst = (Instruction) {0xF7, "*ISB\0", 2, 6, ZeroPageX}; return inst;
-		case 0xEF: inst = (Instruction) {0xEF, "*ISB\0", 3, 6, Absolute}; return inst;
-		case 0xFF: inst = (Instruction) {0xFF, "*ISB\0", 3, 7, AbsoluteX}; return inst;
-		case 0xFB: inst = (Instruction) {0xFB, "*ISB\0", 3, 7, AbsoluteY}; return inst;
-		case 0xE3: inst = (Instruction) {0xE3, "*ISB\0", 2, 8, IndirectX}; return inst;
-		case 0xF3: inst = (Instruction) {0xF3, "*ISB\0", 2, 8, IndirectY}; return inst;
-
-        // KIL: Stop program counter. Affects no flags.
-        case 0x02: inst = (Instruction) {0x02, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x12: inst = (Instruction) {0x12, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x22: inst = (Instruction) {0x22, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x32: inst = (Instruction) {0x32, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x42: inst = (Instruction) {0x42, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x52: inst = (Instruction) {0x52, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x62: inst = (Instruction) {0x62, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x72: inst = (Instruction) {0x72, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0x92: inst = (Instruction) {0x92, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0xB2: inst = (Instruction) {0xB2, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0xD2: inst = (Instruction) {0xD2, "*KIL\0", 1, 0, Implied}; return inst;
-		case 0xF2: inst = (Instruction) {0xF2, "*KIL\0", 1, 0, Implied}; return inst;
-
-        // LAE: AND with stack pointer and transfer result to X, accumulator and stack
-        // pointer.
-        case 0xBB: inst = (Instruction) {0xBB, "*LAE\0", 3, 4, AbsoluteY}; return inst;
-
-        // LAX: Load accumulator and X register
-        case 0xA7: inst = (Instruction) {0xA7, "*LAX\0", 2, 3, ZeroPage}; return inst;
-        case 0xB7: inst = (Instruction) {0xB7, "*LAX\0", 2, 4, ZeroPageY}; return inst;
-        case 0xAF: inst = (Instruction) {0xAF, "*LAX\0", 3, 4, Absolute}; return inst;
-        case 0xBF: inst = (Instruction) {0xBF, "*LAX\0", 3, 4, AbsoluteY}; return inst;
-        case 0xA3: inst = (Instruction) {0xA3, "*LAX\0", 2, 6, IndirectX}; return inst;
-        case 0xB3: inst = (Instruction) {0xB3, "*LAX\0", 2, 5, IndirectY}; return inst;
-
-        // LXA: AND with accumulator then transfer accumulator to register X
-        case 0xAB: inst = (Instruction) {0xAB, "*LXA\0", 2, 2, Immediate}; return inst;
-
-        // NOP
-        case 0x1A: inst = (Instruction) {0x1A, "*NOP\0", 1, 2, Implied}; return inst;
-		case 0x3A: inst = (Instruction) {0x3A, "*NOP\0", 1, 2, Implied}; return inst;
-		case 0x5A: inst = (Instruction) {0x5A, "*NOP\0", 1, 2, Implied}; return inst;
-		case 0x7A: inst = (Instruction) {0x7A, "*NOP\0", 1, 2, Implied}; return inst;
-		case 0xDA: inst = (Instruction) {0xDA, "*NOP\0", 1, 2, Implied}; return inst;
-		case 0xFA: inst = (Instruction) {0xFA, "*NOP\0", 1, 2, Implied}; return inst;
-
-        // RLA: Rotate left then AND with accumulator
-        case 0x27: inst = (Instruction) {0x27, "*RLA\0", 2, 5, ZeroPage}; return inst;
-		case 0x37: inst = (Instruction) {0x37, "*RLA\0", 2, 6, ZeroPageX}; return inst;
-		case 0x2F: inst = (Instruction) {0x2F, "*RLA\0", 3, 6, Absolute}; return inst;
-		case 0x3F: inst = (Instruction) {0x3F, "*RLA\0", 3, 7, AbsoluteX}; return inst;
-		case 0x3B: inst = (Instruction) {0x3B, "*RLA\0", 3, 7, AbsoluteY}; return inst;
-		case 0x23: inst = (Instruction) {0x23, "*RLA\0", 2, 8, IndirectX}; return inst;
-		case 0x33: inst = (Instruction) {0x33, "*RLA\0", 2, 8, IndirectY}; return inst;
-
-        // RRA: Rotate right then add to accumulator
-        case 0x67: inst = (Instruction) {0x67, "*RRA\0", 2, 5, ZeroPage}; return inst;
-		case 0x77: inst = (Instruction) {0x77, "*RRA\0", 2, 6, ZeroPageX}; return inst;
-		case 0x6F: inst = (Instruction) {0x6F, "*RRA\0", 3, 6, Absolute}; return inst;
-		case 0x7F: inst = (Instruction) {0x7F, "*RRA\0", 3, 7, AbsoluteX}; return inst;
-		case 0x7B: inst = (Instruction) {0x7B, "*RRA\0", 3, 7, AbsoluteY}; return inst;
-		case 0x63: inst = (Instruction) {0x63, "*RRA\0", 2, 8, IndirectX}; return inst;
-		case 0x73: inst = (Instruction) {0x73, "*RRA\0", 2, 8, IndirectY}; return inst;
-
-        // SAX: AND registers X and A and store the result at address
-        // Doesn't affect any flags
-        case 0x87: inst = (Instruction) {0x87, "*SAX\0", 2, 3, ZeroPage}; return inst;
-        case 0x97: inst = (Instruction) {0x97, "*SAX\0", 2, 4, ZeroPageY}; return inst;
-        case 0x8F: inst = (Instruction) {0x8F, "*SAX\0", 3, 4, Absolute}; return inst;
-        case 0x83: inst = (Instruction) {0x83, "*SAX\0", 2, 6, IndirectX}; return inst;
-
-        // Identical to official opcode 0xEB
-        case 0xEB: inst = (Instruction) {0xEB, "*SBC\0", 2, 2, Immediate}; return inst;
-
-        // SBX: AND X with accumulator and store result in X, then subtract byte from X
-        // without borrow
-        case 0xCB: inst = (Instruction) {0xCB, "*SBX\0", 2, 2, Immediate}; return inst;
-
-        // SHA: AND X and accumulator then AND result with 7 and store in memory
-        // Affects no status flags
-        case 0x9F: inst = (Instruction) {0x9F, "*SHA\0", 3, 5, AbsoluteY}; return inst;
-        case 0x93: inst = (Instruction) {0x93, "*SHA\0", 2, 6, IndirectY}; return inst;
-
-        // SHS: AND X with accumulator and store result in stack pointer
-        // Then AND stack pointer with the high byte of the target address + 1
-        // Store result in memory
-        case 0x9B: inst = (Instruction) {0x9B, "*SHS\0", 3, 5, AbsoluteY}; return inst;
-
-        // SHX: AND X with the high byte of the target address + 1
-        // Store result in memory
-        case 0x9E: inst = (Instruction) {0x9E, "*SHX\0", 3, 5, AbsoluteY}; return inst;
-
-        // SHY: AND X with the high byte of the target address + 1
-        // Store result in memory
-        case 0x9C: inst = (Instruction) {0x9C, "*SHY\0", 3, 5, AbsoluteX}; return inst;
-
-        // SLO: Shift left and OR with accumulator
-        case 0x07: inst = (Instruction) {0x07, "*SLO\0", 2, 5, ZeroPage}; return inst;
-		case 0x17: inst = (Instruction) {0x17, "*SLO\0", 2, 6, ZeroPageX}; return inst;
-		case 0x0F: inst = (Instruction) {0x0F, "*SLO\0", 3, 6, Absolute}; return inst;
-		case 0x1F: inst = (Instruction) {0x1F, "*SLO\0", 3, 7, AbsoluteX}; return inst;
-		case 0x1B: inst = (Instruction) {0x1B, "*SLO\0", 3, 7, AbsoluteY}; return inst;
-		case 0x03: inst = (Instruction) {0x03, "*SLO\0", 2, 8, IndirectX}; return inst;
-		case 0x13: inst = (Instruction) {0x13, "*SLO\0", 2, 8, IndirectY}; return inst;
-
-        // SRE: Shift right then EOR with accumulator
-        case 0x47: inst = (Instruction) {0x47, "*SRE\0", 2, 5, ZeroPage}; return inst;
-		case 0x57: inst = (Instruction) {0x57, "*SRE\0", 2, 6, ZeroPageX}; return inst;
-		case 0x4F: inst = (Instruction) {0x4F, "*SRE\0", 3, 6, Absolute}; return inst;
-		case 0x5F: inst = (Instruction) {0x5F, "*SRE\0", 3, 7, AbsoluteX}; return inst;
-		case 0x5B: inst = (Instruction) {0x5B, "*SRE\0", 3, 7, AbsoluteY}; return inst;
-		case 0x43: inst = (Instruction) {0x43, "*SRE\0", 2, 8, IndirectX}; return inst;
-		case 0x53: inst = (Instruction) {0x53, "*SRE\0", 2, 8, IndirectY}; return inst;
-
-        // TOP -> Triple NOP
-        case 0x0C: inst = (Instruction) {0x0C, "*NOP\0", 3, 4, Absolute}; return inst;
-        case 0x1C: inst = (Instruction) {0x1C, "*NOP\0", 3, 4, AbsoluteX}; return inst;
-		case 0x3C: inst = (Instruction) {0x3C, "*NOP\0", 3, 4, AbsoluteX}; return inst;
-		case 0x5C: inst = (Instruction) {0x5C, "*NOP\0", 3, 4, AbsoluteX}; return inst;
-		case 0x7C: inst = (Instruction) {0x7C, "*NOP\0", 3, 4, AbsoluteX}; return inst;
-		case 0xDC: inst = (Instruction) {0xDC, "*NOP\0", 3, 4, AbsoluteX}; return inst;
-		case 0xFC: inst = (Instruction) {0xFC, "*NOP\0", 3, 4, AbsoluteX}; return inst;
-
-        // XAA: Exact operation unknown
-        case 0x8B: inst = (Instruction) {0x8B, "*XAA\0", 2, 2, Immediate}; return inst; 
-
-        default: inst = (Instruction) {0x00, "BRK\0", 1, 7, Implied}; return inst;
-    }
-}
+// Opcode list
+// opcode, mnemonic, bytes, cycles, mode, handler kind, instruction
+// Unofficial opcodes' mnemonics are prefixed with '*'
+#define OPCODE_LIST(X) \
+    /* In alphabetical order of mnemonics */ \
+    /* Some are grouped by functionality, but that is just an alphabetical coincidence */ \
+    X(0x69, "ADC", 2, 2, Immediate, MODE, adc) \
+    X(0x65, "ADC", 2, 3, ZeroPage, MODE, adc) \
+    X(0x75, "ADC", 2, 4, ZeroPageX, MODE, adc) \
+    X(0x6D, "ADC", 3, 4, Absolute, MODE, adc) \
+    X(0x7D, "ADC", 3, 4, AbsoluteX, MODE, adc) \
+    X(0x79, "ADC", 3, 4, AbsoluteY, MODE, adc) \
+    X(0x61, "ADC", 2, 6, IndirectX, MODE, adc) \
+    X(0x71, "ADC", 2, 5, IndirectY, MODE, adc) \
+    \
+    X(0x29, "AND", 2, 2, Immediate, MODE, and) \
+    X(0x25, "AND", 2, 3, ZeroPage, MODE, and) \
+    X(0x35, "AND", 2, 4, ZeroPageX, MODE, and) \
+    X(0x2D, "AND", 3, 4, Absolute, MODE, and) \
+    X(0x3D, "AND", 3, 4, AbsoluteX, MODE, and) \
+    X(0x39, "AND", 3, 4, AbsoluteY, MODE, and) \
+    X(0x21, "AND", 2, 6, IndirectX, MODE, and) \
+    X(0x31, "AND", 2, 5, IndirectY, MODE, and) \
+    \
+    X(0x0A, "ASL", 1, 2, Implied, IMPLIED, asl_acc) \
+    X(0x06, "ASL", 2, 5, ZeroPage, MODE, asl) \
+    X(0x16, "ASL", 2, 6, ZeroPageX, MODE, asl) \
+    X(0x0E, "ASL", 3, 6, Absolute, MODE, asl) \
+    X(0x1E, "ASL", 3, 7, AbsoluteX, MODE, asl) \
+    \
+    /* Branch instructions part 1 */ \
+    X(0x90, "BCC", 2, 2, Relative, BRANCH, bcc) \
+    X(0xB0, "BCS", 2, 2, Relative, BRANCH, bcs) \
+    X(0xF0, "BEQ", 2, 2, Relative, BRANCH, beq) \
+    \
+    X(0x24, "BIT", 2, 3, ZeroPage, MODE, bit) \
+    X(0x2C, "BIT", 3, 4, Absolute, MODE, bit) \
+    \
+    /* Branch instructions part 2 */ \
+    X(0x30, "BMI", 2, 2, Relative, BRANCH, bmi) \
+    X(0xD0, "BNE", 2, 2, Relative, BRANCH, bne) \
+    X(0x10, "BPL", 2, 2, Relative, BRANCH, bpl) \
+    \
+    X(0x00, "BRK", 1, 7, Implied, HALT, brk) \
+    \
+    /* Branch instructions part 3 */ \
+    X(0x50, "BVC", 2, 2, Relative, BRANCH, bvc) \
+    X(0x70, "BVS", 2, 2, Relative, BRANCH, bvs) \
+    \
+    /* Clear instructions */ \
+    X(0x18, "CLC", 1, 2, Implied, IMPLIED, clc) \
+    X(0xD8, "CLD", 1, 2, Implied, IMPLIED, cld) \
+    X(0x58, "CLI", 1, 2, Implied, IMPLIED, cli) \
+    X(0xB8, "CLV", 1, 2, Implied, IMPLIED, clv) \
+    \
+    /* Compare instructions */ \
+    X(0xC9, "CMP", 2, 2, Immediate, MODE, cmp) \
+    X(0xC5, "CMP", 2, 3, ZeroPage, MODE, cmp) \
+    X(0xD5, "CMP", 2, 4, ZeroPageX, MODE, cmp) \
+    X(0xCD, "CMP", 3, 4, Absolute, MODE, cmp) \
+    X(0xDD, "CMP", 3, 4, AbsoluteX, MODE, cmp) \
+    X(0xD9, "CMP", 3, 4, AbsoluteY, MODE, cmp) \
+    X(0xC1, "CMP", 2, 6, IndirectX, MODE, cmp) \
+    X(0xD1, "CMP", 2, 5, IndirectY, MODE, cmp) \
+    \
+    X(0xE0, "CPX", 2, 2, Immediate, MODE, cpx) \
+    X(0xE4, "CPX", 2, 3, ZeroPage, MODE, cpx) \
+    X(0xEC, "CPX", 3, 4, Absolute, MODE, cpx) \
+    \
+    X(0xC0, "CPY", 2, 2, Immediate, MODE, cpy) \
+    X(0xC4, "CPY", 2, 3, ZeroPage, MODE, cpy) \
+    X(0xCC, "CPY", 3, 4, Absolute, MODE, cpy) \
+    \
+    /* Decrement instructions */ \
+    X(0xC6, "DEC", 2, 5, ZeroPage, MODE, dec) \
+    X(0xD6, "DEC", 2, 6, ZeroPageX, MODE, dec) \
+    X(0xCE, "DEC", 3, 6, Absolute, MODE, dec) \
+    X(0xDE, "DEC", 3, 7, AbsoluteX, MODE, dec) \
+    \
+    X(0xCA, "DEX", 1, 2, Implied, IMPLIED, dex) \
+    X(0x88, "DEY", 1, 2, Implied, IMPLIED, dey) \
+    \
+    X(0x49, "EOR", 2, 2, Immediate, MODE, eor) \
+    X(0x45, "EOR", 2, 3, ZeroPage, MODE, eor) \
+    X(0x55, "EOR", 2, 4, ZeroPageX, MODE, eor) \
+    X(0x4D, "EOR", 3, 4, Absolute, MODE, eor) \
+    X(0x5D, "EOR", 3, 4, AbsoluteX, MODE, eor) \
+    X(0x59, "EOR", 3, 4, AbsoluteY, MODE, eor) \
+    X(0x41, "EOR", 2, 6, IndirectX, MODE, eor) \
+    X(0x51, "EOR", 2, 5, IndirectY, MODE, eor) \
+    \
+    /* Increment instructions */ \
+    X(0xE6, "INC", 2, 5, ZeroPage, MODE, inc) \
+    X(0xF6, "INC", 2, 6, ZeroPageX, MODE, inc) \
+    X(0xEE, "INC", 3, 6, Absolute, MODE, inc) \
+    X(0xFE, "INC", 3, 7, AbsoluteX, MODE, inc) \
+    \
+    X(0xE8, "INX", 1, 2, Implied, IMPLIED, inx) \
+    \
+    X(0xC8, "INY", 1, 2, Implied, IMPLIED, iny) \
+    \
+    /* Jump instructions */ \
+    X(0x4C, "JMP", 3, 3, Absolute, JUMP, jmp) \
+    X(0x6C, "JMP", 3, 5, Indirect, JUMP, jmp) \
+    \
+    X(0x20, "JSR", 3, 6, Absolute, BRANCH, jsr) \
+    \
+    /* Load instructions */ \
+    X(0xA9, "LDA", 2, 2, Immediate, MODE, lda) \
+    X(0xA5, "LDA", 2, 3, ZeroPage, MODE, lda) \
+    X(0xB5, "LDA", 2, 4, ZeroPageX, MODE, lda) \
+    X(0xAD, "LDA", 3, 4, Absolute, MODE, lda) \
+    X(0xBD, "LDA", 3, 4, AbsoluteX, MODE, lda) \
+    X(0xB9, "LDA", 3, 4, AbsoluteY, MODE, lda) \
+    X(0xA1, "LDA", 2, 6, IndirectX, MODE, lda) \
+    X(0xB1, "LDA", 2, 5, IndirectY, MODE, lda) \
+    \
+    X(0xA2, "LDX", 2, 2, Immediate, MODE, ldx) \
+    X(0xA6, "LDX", 2, 3, ZeroPage, MODE, ldx) \
+    X(0xB6, "LDX", 2, 4, ZeroPageY, MODE, ldx) \
+    X(0xAE, "LDX", 3, 4, Absolute, MODE, ldx) \
+    X(0xBE, "LDX", 3, 4, AbsoluteY, MODE, ldx) \
+    \
+    X(0xA0, "LDY", 2, 2, Immediate, MODE, ldy) \
+    X(0xA4, "LDY", 2, 3, ZeroPage, MODE, ldy) \
+    X(0xB4, "LDY", 2, 4, ZeroPageX, MODE, ldy) \
+    X(0xAC, "LDY", 3, 4, Absolute, MODE, ldy) \
+    X(0xBC, "LDY", 3, 4, AbsoluteX, MODE, ldy) \
+    \
+    X(0x4A, "LSR", 1, 2, Implied, IMPLIED, lsr_acc) \
+    X(0x46, "LSR", 2, 5, ZeroPage, MODE, lsr) \
+    X(0x56, "LSR", 2, 6, ZeroPageX, MODE, lsr) \
+    X(0x4E, "LSR", 3, 6, Absolute, MODE, lsr) \
+    X(0x5E, "LSR", 3, 7, AbsoluteX, MODE, lsr) \
+    \
+    X(0xEA, "NOP", 1, 2, Implied, NOP, nop) \
+    \
+    X(0x09, "ORA", 2, 2, Immediate, MODE, ora) \
+    X(0x05, "ORA", 2, 3, ZeroPage, MODE, ora) \
+    X(0x15, "ORA", 2, 4, ZeroPageX, MODE, ora) \
+    X(0x0D, "ORA", 3, 4, Absolute, MODE, ora) \
+    X(0x1D, "ORA", 3, 4, AbsoluteX, MODE, ora) \
+    X(0x19, "ORA", 3, 4, AbsoluteY, MODE, ora) \
+    X(0x01, "ORA", 2, 6, IndirectX, MODE, ora) \
+    X(0x11, "ORA", 2, 5, IndirectY, MODE, ora) \
+    \
+    /* Push instructions */ \
+    X(0x48, "PHA", 1, 3, Implied, IMPLIED, pha) \
+    X(0x08, "PHP", 1, 3, Implied, IMPLIED, php) \
+    \
+    /* Pull instructions */ \
+    X(0x68, "PLA", 1, 4, Implied, IMPLIED, pla) \
+    X(0x28, "PLP", 1, 4, Implied, IMPLIED, plp) \
+    \
+    /* Rotate instructions */ \
+    X(0x2A, "ROL", 1, 2, Implied, IMPLIED, rol_acc) \
+    X(0x26, "ROL", 2, 5, ZeroPage, MODE, rol) \
+    X(0x36, "ROL", 2, 6, ZeroPageX, MODE, rol) \
+    X(0x2E, "ROL", 3, 6, Absolute, MODE, rol) \
+    X(0x3E, "ROL", 3, 7, AbsoluteX, MODE, rol) \
+    \
+    X(0x6A, "ROR", 1, 2, Implied, IMPLIED, ror_acc) \
+    X(0x66, "ROR", 2, 5, ZeroPage, MODE, ror) \
+    X(0x76, "ROR", 2, 6, ZeroPageX, MODE, ror) \
+    X(0x6E, "ROR", 3, 6, Absolute, MODE, ror) \
+    X(0x7E, "ROR", 3, 7, AbsoluteX, MODE, ror) \
+    \
+    /* Return instructions */ \
+    X(0x40, "RTI", 1, 6, Implied, BRANCH, rti) \
+    X(0x60, "RTS", 1, 6, Implied, BRANCH, rts) \
+    \
+    X(0xE9, "SBC", 2, 2, Immediate, MODE, sbc) \
+    X(0xE5, "SBC", 2, 3, ZeroPage, MODE, sbc) \
+    X(0xF5, "SBC", 2, 4, ZeroPageX, MODE, sbc) \
+    X(0xED, "SBC", 3, 4, Absolute, MODE, sbc) \
+    X(0xFD, "SBC", 3, 4, AbsoluteX, MODE, sbc) \
+    X(0xF9, "SBC", 3, 4, AbsoluteY, MODE, sbc) \
+    X(0xE1, "SBC", 2, 6, IndirectX, MODE, sbc) \
+    X(0xF1, "SBC", 2, 5, IndirectY, MODE, sbc) \
+    \
+    /* Set flag intructions */ \
+    X(0x38, "SEC", 1, 2, Implied, IMPLIED, sec) \
+    X(0xF8, "SED", 1, 2, Implied, IMPLIED, sed) \
+    X(0x78, "SEI", 1, 2, Implied, IMPLIED, sei) \
+    \
+    /* Store instructions */ \
+    X(0x85, "STA", 2, 3, ZeroPage, MODE, sta) \
+    X(0x95, "STA", 2, 4, ZeroPageX, MODE, sta) \
+    X(0x8D, "STA", 3, 4, Absolute, MODE, sta) \
+    X(0x9D, "STA", 3, 5, AbsoluteX, MODE, sta) \
+    X(0x99, "STA", 3, 5, AbsoluteY, MODE, sta) \
+    X(0x81, "STA", 2, 6, IndirectX, MODE, sta) \
+    X(0x91, "STA", 2, 6, IndirectY, MODE, sta) \
+    \
+    X(0x86, "STX", 2, 3, ZeroPage, MODE, stx) \
+    X(0x96, "STX", 2, 4, ZeroPageY, MODE, stx) \
+    X(0x8E, "STX", 3, 4, Absolute, MODE, stx) \
+    \
+    X(0x84, "STY", 2, 3, ZeroPage, MODE, sty) \
+    X(0x94, "STY", 2, 4, ZeroPageX, MODE, sty) \
+    X(0x8C, "STY", 3, 4, Absolute, MODE, sty) \
+    \
+    /* Transfer instructions */ \
+    X(0xAA, "TAX", 1, 2, Implied, IMPLIED, tax) \
+    X(0xA8, "TAY", 1, 2, Implied, IMPLIED, tay) \
+    X(0xBA, "TSX", 1, 2, Implied, IMPLIED, tsx) \
+    X(0x8A, "TXA", 1, 2, Implied, IMPLIED, txa) \
+    X(0x9A, "TXS", 1, 2, Implied, IMPLIED, txs) \
+    X(0x98, "TYA", 1, 2, Implied, IMPLIED, tya) \
+    \
+    /* Unofficial opcodes */ \
+    \
+    /* ANC: AND with accumulator. Sets carry is result is negative. */ \
+    X(0x0B, "*ANC", 2, 2, Immediate, MODE, anc) \
+    X(0x2B, "*ANC", 2, 2, Immediate, MODE, anc) \
+    \
+    /* ARR: AND with accumulator then rotate accumulator one bit to the right */ \
+    /* Check bits 5 and 6: */ \
+    /* If both bits are 1: set C, clear V. */ \
+    /* If both bits are 0: clear C and V. */ \
+    /* If only bit 5 is 1: set V, clear C. */ \
+    /* If only bit 6 is 1: set C and V. */ \
+    X(0x6B, "*ARR", 2, 2, Immediate, MODE, arr) \
+    \
+    /* ASR: AND with accumulator then shift one bit to the right */ \
+    X(0x4B, "*ASR", 2, 2, Immediate, MODE, asr) \
+    \
+    /* DCP: Decrement memory and compare with accumulator */ \
+    X(0xC7, "*DCP", 2, 5, ZeroPage, MODE, dcp) \
+    X(0xD7, "*DCP", 2, 6, ZeroPageX, MODE, dcp) \
+    X(0xCF, "*DCP", 3, 6, Absolute, MODE, dcp) \
+    X(0xDF, "*DCP", 3, 7, AbsoluteX, MODE, dcp) \
+    X(0xDB, "*DCP", 3, 7, AbsoluteY, MODE, dcp) \
+    X(0xC3, "*DCP", 2, 8, IndirectX, MODE, dcp) \
+    X(0xD3, "*DCP", 2, 8, IndirectY, MODE, dcp) \
+    \
+    /* DOP (NOP) -> Double NOP */ \
+    X(0x80, "*NOP", 2, 2, Immediate, NOP, nop) \
+    X(0x82, "*NOP", 2, 2, Immediate, NOP, nop) \
+    X(0x89, "*NOP", 2, 2, Immediate, NOP, nop) \
+    X(0xC2, "*NOP", 2, 2, Immediate, NOP, nop) \
+    X(0xE2, "*NOP", 2, 2, Immediate, NOP, nop) \
+    X(0x04, "*NOP", 2, 3, ZeroPage, NOP, nop) \
+    X(0x44, "*NOP", 2, 3, ZeroPage, NOP, nop) \
+    X(0x64, "*NOP", 2, 3, ZeroPage, NOP, nop) \
+    X(0x14, "*NOP", 2, 4, ZeroPageX, NOP, nop) \
+    X(0x34, "*NOP", 2, 4, ZeroPageX, NOP, nop) \
+    X(0x54, "*NOP", 2, 4, ZeroPageX, NOP, nop) \
+    X(0x74, "*NOP", 2, 4, ZeroPageX, NOP, nop) \
+    X(0xD4, "*NOP", 2, 4, ZeroPageX, NOP, nop) \
+    X(0xF4, "*NOP", 2, 4, ZeroPageX, NOP, nop) \
+    \
+    /* ISB: Increment memory then subtract it from accumulator */ \
+    X(0xE7, "*ISB", 2, 5, ZeroPage, MODE, isb) \
+    X(0xF7, "*ISB", 2, 6, ZeroPageX, MODE, isb) \
+    X(0xEF, "*ISB", 3, 6, Absolute, MODE, isb) \
+    X(0xFF, "*ISB", 3, 7, AbsoluteX, MODE, isb) \
+    X(0xFB, "*ISB", 3, 7, AbsoluteY, MODE, isb) \
+    X(0xE3, "*ISB", 2, 8, IndirectX, MODE, isb) \
+    X(0xF3, "*ISB", 2, 8, IndirectY, MODE, isb) \
+    \
+    /* KIL: Stop program counter. Affects no flags. */ \
+    X(0x02, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x12, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x22, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x32, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x42, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x52, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x62, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x72, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0x92, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0xB2, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0xD2, "*KIL", 1, 0, Implied, HALT, kil) \
+    X(0xF2, "*KIL", 1, 0, Implied, HALT, kil) \
+    \
+    /* LAE: AND with stack pointer and transfer result to X, accumulator and stack */ \
+    /* pointer. */ \
+    X(0xBB, "*LAE", 3, 4, AbsoluteY, MODE, lae) \
+    \
+    /* LAX: Load accumulator and X register */ \
+    X(0xA7, "*LAX", 2, 3, ZeroPage, MODE, lax) \
+    X(0xB7, "*LAX", 2, 4, ZeroPageY, MODE, lax) \
+    X(0xAF, "*LAX", 3, 4, Absolute, MODE, lax) \
+    X(0xBF, "*LAX", 3, 4, AbsoluteY, MODE, lax) \
+    X(0xA3, "*LAX", 2, 6, IndirectX, MODE, lax) \
+    X(0xB3, "*LAX", 2, 5, IndirectY, MODE, lax) \
+    \
+    /* LXA: AND with accumulator then transfer accumulator to register X */ \
+    X(0xAB, "*LXA", 2, 2, Immediate, MODE, lxa) \
+    \
+    /* NOP */ \
+    X(0x1A, "*NOP", 1, 2, Implied, NOP, nop) \
+    X(0x3A, "*NOP", 1, 2, Implied, NOP, nop) \
+    X(0x5A, "*NOP", 1, 2, Implied, NOP, nop) \
+    X(0x7A, "*NOP", 1, 2, Implied, NOP, nop) \
+    X(0xDA, "*NOP", 1, 2, Implied, NOP, nop) \
+    X(0xFA, "*NOP", 1, 2, Implied, NOP, nop) \
+    \
+    /* RLA: Rotate left then AND with accumulator */ \
+    X(0x27, "*RLA", 2, 5, ZeroPage, MODE, rla) \
+    X(0x37, "*RLA", 2, 6, ZeroPageX, MODE, rla) \
+    X(0x2F, "*RLA", 3, 6, Absolute, MODE, rla) \
+    X(0x3F, "*RLA", 3, 7, AbsoluteX, MODE, rla) \
+    X(0x3B, "*RLA", 3, 7, AbsoluteY, MODE, rla) \
+    X(0x23, "*RLA", 2, 8, IndirectX, MODE, rla) \
+    X(0x33, "*RLA", 2, 8, IndirectY, MODE, rla) \
+    \
+    /* RRA: Rotate right then add to accumulator */ \
+    X(0x67, "*RRA", 2, 5, ZeroPage, MODE, rra) \
+    X(0x77, "*RRA", 2, 6, ZeroPageX, MODE, rra) \
+    X(0x6F, "*RRA", 3, 6, Absolute, MODE, rra) \
+    X(0x7F, "*RRA", 3, 7, AbsoluteX, MODE, rra) \
+    X(0x7B, "*RRA", 3, 7, AbsoluteY, MODE, rra) \
+    X(0x63, "*RRA", 2, 8, IndirectX, MODE, rra) \
+    X(0x73, "*RRA", 2, 8, IndirectY, MODE, rra) \
+    \
+    /* SAX: AND registers X and A and store the result at address */ \
+    /* Doesn't affect any flags */ \
+    X(0x87, "*SAX", 2, 3, ZeroPage, MODE, sax) \
+    X(0x97, "*SAX", 2, 4, ZeroPageY, MODE, sax) \
+    X(0x8F, "*SAX", 3, 4, Absolute, MODE, sax) \
+    X(0x83, "*SAX", 2, 6, IndirectX, MODE, sax) \
+    \
+    /* Identical to official opcode 0xEB */ \
+    X(0xEB, "*SBC", 2, 2, Immediate, MODE, sbc) \
+    \
+    /* SBX: AND X with accumulator and store result in X, then subtract byte from X */ \
+    /* without borrow */ \
+    X(0xCB, "*SBX", 2, 2, Immediate, MODE, sbx) \
+    \
+    /* SHA: AND X and accumulator then AND result with 7 and store in memory */ \
+    /* Affects no status flags */ \
+    X(0x9F, "*SHA", 3, 5, AbsoluteY, MODE, sha) \
+    X(0x93, "*SHA", 2, 6, IndirectY, MODE, sha) \
+    \
+    /* SHS: AND X with accumulator and store result in stack pointer */ \
+    /* Then AND stack pointer with the high byte of the target address + 1 */ \
+    /* Store result in memory */ \
+    X(0x9B, "*SHS", 3, 5, AbsoluteY, MODE, shs) \
+    \
+    /* SHX: AND X with the high byte of the target address + 1 */ \
+    /* Store result in memory */ \
+    X(0x9E, "*SHX", 3, 5, AbsoluteY, MODE, shx) \
+    \
+    /* SHY: AND X with the high byte of the target address + 1 */ \
+    /* Store result in memory */ \
+    X(0x9C, "*SHY", 3, 5, AbsoluteX, MODE, shy) \
+    \
+    /* SLO: Shift left and OR with accumulator */ \
+    X(0x07, "*SLO", 2, 5, ZeroPage, MODE, slo) \
+    X(0x17, "*SLO", 2, 6, ZeroPageX, MODE, slo) \
+    X(0x0F, "*SLO", 3, 6, Absolute, MODE, slo) \
+    X(0x1F, "*SLO", 3, 7, AbsoluteX, MODE, slo) \
+    X(0x1B, "*SLO", 3, 7, AbsoluteY, MODE, slo) \
+    X(0x03, "*SLO", 2, 8, IndirectX, MODE, slo) \
+    X(0x13, "*SLO", 2, 8, IndirectY, MODE, slo) \
+    \
+    /* SRE: Shift right then EOR with accumulator */ \
+    X(0x47, "*SRE", 2, 5, ZeroPage, MODE, sre) \
+    X(0x57, "*SRE", 2, 6, ZeroPageX, MODE, sre) \
+    X(0x4F, "*SRE", 3, 6, Absolute, MODE, sre) \
+    X(0x5F, "*SRE", 3, 7, AbsoluteX, MODE, sre) \
+    X(0x5B, "*SRE", 3, 7, AbsoluteY, MODE, sre) \
+    X(0x43, "*SRE", 2, 8, IndirectX, MODE, sre) \
+    X(0x53, "*SRE", 2, 8, IndirectY, MODE, sre) \
+    \
+    /* TOP -> Triple NOP */ \
+    X(0x0C, "*NOP", 3, 4, Absolute, NOP, nop) \
+    X(0x1C, "*NOP", 3, 4, AbsoluteX, NOP, nop) \
+    X(0x3C, "*NOP", 3, 4, AbsoluteX, NOP, nop) \
+    X(0x5C, "*NOP", 3, 4, AbsoluteX, NOP, nop) \
+    X(0x7C, "*NOP", 3, 4, AbsoluteX, NOP, nop) \
+    X(0xDC, "*NOP", 3, 4, AbsoluteX, NOP, nop) \
+    X(0xFC, "*NOP", 3, 4, AbsoluteX, NOP, nop) \
+    \
+    /* XAA: Exact operation unknown */ \
+    X(0x8B, "*XAA", 2, 2, Immediate, MODE, xaa)
+
+#define OPCODE_INFO_ENTRY(opcode, mnemonic, bytes, cycles, mode, kind, instruction) \
+    [opcode] = {bytes, cycles, mode},
+#define OPCODE_MNEMONIC_ENTRY(opcode, mnemonic, bytes, cycles, mode, kind, instruction) \
+    [opcode] = mnemonic,
+
+const OpcodeInfo OPCODE_TABLE[0x100] = {
+    OPCODE_LIST(OPCODE_INFO_ENTRY)
+};
+
+const char OPCODE_MNEMONICS[0x100][5] = {
+    OPCODE_LIST(OPCODE_MNEMONIC_ENTRY)
+};
 
 // Instructions
 
@@ -438,23 +439,13 @@ void beq(CPU *cpu) {
 void bit(CPU *cpu, AddrMode mode) {
     uint8_t operand = get_operand(cpu, mode, false);
 
-    ((cpu->reg_a & operand) == 0) ? set_flag(cpu, ZERO_FLAG) : unset_flag(cpu, ZERO_FLAG);
+    cpu->zero_result = cpu->reg_a & operand;
     
     // Set V flag to operand 6th bit
-    if ((operand & 0b01000000) != 0) {
-        set_flag(cpu, OVERFLOW_FLAG);
-    }
-    else {
-        unset_flag(cpu, OVERFLOW_FLAG);
-    }
+    cpu->overflow = (operand & 0b01000000) != 0;
 
     // Set N flag to operand 7th bit
-    if ((operand & 0b10000000) != 0) {
-        set_flag(cpu, NEGATIVE_FLAG);
-    }
-    else {
-        unset_flag(cpu, NEGATIVE_FLAG);
-    }
+    cpu->negative_result = operand;
 }
 
 // Branch instructions part 2
@@ -507,36 +498,21 @@ void clv(CPU *cpu) {
 
 void cmp(CPU *cpu, AddrMode mode) {
     uint8_t operand = get_operand(cpu, mode, true);
-    if (cpu->reg_a >= operand) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = cpu->reg_a >= operand;
     uint8_t result = cpu->reg_a - operand;
     update_zero_and_negative_flags(cpu, result);
 }
 
 void cpx(CPU *cpu, AddrMode mode) {
     uint8_t operand = get_operand(cpu, mode, false);
-    if (cpu->reg_x >= operand) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = cpu->reg_x >= operand;
     uint8_t result = cpu->reg_x - operand;
     update_zero_and_negative_flags(cpu, result);
 }
 
 void cpy(CPU *cpu, AddrMode mode) {
     uint8_t operand = get_operand(cpu, mode, false);
-    if (cpu->reg_y >= operand) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = cpu->reg_y >= operand;
     uint8_t result = cpu->reg_y - operand;
     update_zero_and_negative_flags(cpu, result);
 }
@@ -618,24 +594,14 @@ void ldy(CPU *cpu, AddrMode mode) {
 }
 
 void lsr_acc(CPU *cpu) {
-    if ((cpu->reg_a & 1) != 0) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (cpu->reg_a & 1) != 0;
     set_reg_a(cpu, cpu->reg_a >> 1);
 }
 
 void lsr(CPU *cpu, AddrMode mode) {
     uint16_t addr = get_operand_addr(cpu, mode, false);
     uint8_t operand = mem_read(cpu, addr);
-    if ((operand & 1) != 0) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (operand & 1) != 0;
     mem_write(cpu, operand >> 1, addr);
     update_zero_and_negative_flags(cpu, operand >> 1);
 }
@@ -652,11 +618,8 @@ void pha(CPU *cpu) {
 }
 
 void php(CPU *cpu) {
-    uint8_t old_status_register = cpu->status;
-    set_flag(cpu, BREAK_FLAG_0);
-    set_flag(cpu, BREAK_FLAG_1);
-    stack_push(cpu, cpu->status);
-    cpu->status = old_status_register;
+    // The B flags are only set on the pushed copy
+    stack_push(cpu, get_status(cpu) | BREAK_FLAG_0 | BREAK_FLAG_1);
 }
 
 // Pull instructions
@@ -667,7 +630,7 @@ void pla(CPU *cpu) {
 }
 
 void plp(CPU *cpu) {
-    cpu->status = stack_pull(cpu);
+    set_status(cpu, stack_pull(cpu));
     unset_flag(cpu, BREAK_FLAG_0); // This flag is ignored by this instruction
     set_flag(cpu, BREAK_FLAG_1); // This flag must always be set
 }
@@ -681,12 +644,7 @@ void rol_acc(CPU *cpu) {
         set_reg_a(cpu, cpu->reg_a | 0x01);
     }
     
-    if ((old_acc & 0x80) != 0) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (old_acc & 0x80) != 0;
 }
 
 void rol(CPU *cpu, AddrMode mode) {
@@ -696,12 +654,7 @@ void rol(CPU *cpu, AddrMode mode) {
     if (is_set(cpu, CARRY_FLAG)) {
         new_value |= 0x01;
     }
-    if (operand & 0x80) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (operand & 0x80) != 0;
     mem_write(cpu, new_value, addr);
     update_zero_and_negative_flags(cpu, new_value);
 }
@@ -712,12 +665,7 @@ void ror_acc(CPU *cpu) {
     if (is_set(cpu, CARRY_FLAG)) {
         set_reg_a(cpu, cpu->reg_a | 0x80);
     }
-    if ((old_acc & 0x01) != 0) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (old_acc & 0x01) != 0;
 }
 
 void ror(CPU *cpu, AddrMode mode) {
@@ -727,12 +675,7 @@ void ror(CPU *cpu, AddrMode mode) {
     if (is_set(cpu, CARRY_FLAG)) {
         new_value |= 0x80;
     }
-    if ((operand & 0x01) != 0) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (operand & 0x01) != 0;
     mem_write(cpu, new_value, addr);
     update_zero_and_negative_flags(cpu, new_value);
 }
@@ -743,7 +686,7 @@ void ror(CPU *cpu, AddrMode mode) {
 void rti(CPU *cpu) {
     uint8_t flags = stack_pull(cpu);
     uint16_t program_counter = stack_pull_u16(cpu);
-    cpu->status = flags;
+    set_status(cpu, flags);
     // "Disregards" bits 5 and 4, which means 5 is set and 4 isn't
     set_flag(cpu, BREAK_FLAG_1);
     unset_flag(cpu, BREAK_FLAG_0);
@@ -834,19 +777,8 @@ void arr(CPU *cpu, AddrMode mode) {
     int bit_5 = (result >> 5) & 1;
     int bit_6 = (result >> 6) & 1;
     
-    if (bit_6) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
-
-    if (bit_5 ^ bit_6) {
-        set_flag(cpu, OVERFLOW_FLAG);
-    }
-    else {
-        unset_flag(cpu, OVERFLOW_FLAG);
-    }
+    cpu->carry = bit_6;
+    cpu->overflow = bit_5 ^ bit_6;
 
     update_zero_and_negative_flags(cpu, result);
 }
@@ -874,6 +806,11 @@ void isb(CPU *cpu, AddrMode mode) {
     sbc(cpu, mode);
 }
 
+// Stops the processor, which is handled by the caller
+void kil(CPU *cpu) {
+    return;
+}
+
 void lae(CPU *cpu, AddrMode mode) {
     uint8_t operand = get_operand(cpu, mode, true);
     uint8_t result = operand & cpu->stack_pointer;
@@ -982,30 +919,14 @@ void branch(CPU *cpu, bool condition) {
     cpu->program_counter++;
 }
 
+// Z and N are only computed from the result when something reads them
 void update_zero_and_negative_flags(CPU *cpu, uint8_t result) {
-    // Update zero flag
-    if (result == 0) {
-        set_flag(cpu, ZERO_FLAG);
-    }
-    else {
-        unset_flag(cpu, ZERO_FLAG);
-    }
-    // Update negative flag
-    if ((result & 0b10000000) != 0) {
-        set_flag(cpu, NEGATIVE_FLAG);
-    }
-    else {
-        unset_flag(cpu, NEGATIVE_FLAG);
-    }
+    cpu->zero_result = result;
+    cpu->negative_result = result;
 }
 
 void update_carry_flag(CPU *cpu, uint8_t value) {
-    if ((value >> 7) == 1) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = (value >> 7) == 1;
 }
 
 uint8_t get_operand(CPU *cpu, AddrMode mode, bool page_crossing) {
@@ -1063,7 +984,7 @@ uint16_t get_operand_addr(CPU *cpu, AddrMode mode, bool page_crossing) {
             base_y++;
             uint8_t high_y = mem_read(cpu, base_y);
             base_u16 = (uint16_t) high_y << 8 | low_y;
-            addr = base_u16 + cpu->program_counter;
+            addr = base_u16 + cpu->reg_y;
             if (page_crossing) {
                 deal_with_page_crossing(cpu, base_u16, addr);
             }
@@ -1076,26 +997,16 @@ uint16_t get_operand_addr(CPU *cpu, AddrMode mode, bool page_crossing) {
 
 // Made to implement both ADC and SBC more easily
 void add_with_carry(CPU *cpu, uint8_t operand) {
-    uint8_t carry_in = is_set(cpu, CARRY_FLAG);
+    uint8_t carry_in = cpu->carry;
     uint16_t sum = (uint16_t) cpu->reg_a + operand + carry_in;
     
     // Check if carry flag must be set
-    if (sum > 0xFF) {
-        set_flag(cpu, CARRY_FLAG);
-    }
-    else {
-        unset_flag(cpu, CARRY_FLAG);
-    }
+    cpu->carry = sum > 0xFF;
     
     // Check if overflow flag must be set
     // Check sources for a detailed explanation
     uint8_t result = (uint8_t) sum;
-    if (((cpu->reg_a ^ result) & (operand ^ result) & 0x80) != 0) {
-        set_flag(cpu, OVERFLOW_FLAG);
-    }
-    else {
-        unset_flag(cpu, OVERFLOW_FLAG);
-    }
+    cpu->overflow = ((cpu->reg_a ^ result) & (operand ^ result) & 0x80) != 0;
     set_reg_a(cpu, result);
 }
 
@@ -1105,3 +1016,74 @@ void deal_with_page_crossing(CPU *cpu, uint16_t base_addr, uint16_t end_addr) {
         cpu->bus->cycles++;
     }
 }
+
+// Opcode dispatch
+
+// Every opcode gets its own handler with the addressing mode fixed at compile time
+// 'flatten' lets GCC inline the instruction and fold the addressing mode switch away
+#if defined(__GNUC__)
+#define OPCODE_HANDLER static __attribute__((flatten)) void
+#else
+#define OPCODE_HANDLER static void
+#endif
+
+// Handler kinds
+// MODE: instruction takes an addressing mode
+// IMPLIED: instruction takes no operand
+// BRANCH and JUMP: instruction sets the program counter itself (JUMP takes an addressing mode)
+// NOP: does nothing besides advancing the program counter
+// HALT: stops execution, only consuming the opcode byte and no cycles (BRK and KIL)
+// Base cycles are counted before the instruction runs, writes are always on its last cycle, so the bus
+// knows which cycle a write lands on (OAM DMA needs it)
+#define HANDLER_MODE(opcode, length, base_cycles, instruction, mode) \
+    OPCODE_HANDLER op_##opcode(CPU *cpu) { \
+        uint16_t original_pc_state = cpu->program_counter++; \
+        cpu->bus->cycles += base_cycles; \
+        instruction(cpu, mode); \
+        cpu->program_counter = original_pc_state + length; \
+    }
+
+#define HANDLER_IMPLIED(opcode, length, base_cycles, instruction, mode) \
+    OPCODE_HANDLER op_##opcode(CPU *cpu) { \
+        uint16_t original_pc_state = cpu->program_counter++; \
+        cpu->bus->cycles += base_cycles; \
+        instruction(cpu); \
+        cpu->program_counter = original_pc_state + length; \
+    }
+
+#define HANDLER_BRANCH(opcode, length, base_cycles, instruction, mode) \
+    OPCODE_HANDLER op_##opcode(CPU *cpu) { \
+        cpu->program_counter++; \
+        cpu->bus->cycles += base_cycles; \
+        instruction(cpu); \
+    }
+
+#define HANDLER_JUMP(opcode, length, base_cycles, instruction, mode) \
+    OPCODE_HANDLER op_##opcode(CPU *cpu) { \
+        cpu->program_counter++; \
+        cpu->bus->cycles += base_cycles; \
+        instruction(cpu, mode); \
+    }
+
+#define HANDLER_NOP(opcode, length, base_cycles, instruction, mode) \
+    OPCODE_HANDLER op_##opcode(CPU *cpu) { \
+        cpu->program_counter += length; \
+        cpu->bus->cycles += base_cycles; \
+    }
+
+#define HANDLER_HALT(opcode, length, base_cycles, instruction, mode) \
+    OPCODE_HANDLER op_##opcode(CPU *cpu) { \
+        cpu->program_counter++; \
+        instruction(cpu); \
+    }
+
+#define DEFINE_HANDLER(opcode, mnemonic, bytes, cycles, mode, kind, instruction) \
+    HANDLER_##kind(opcode, bytes, cycles, instruction, mode)
+#define HANDLER_ENTRY(opcode, mnemonic, bytes, cycles, mode, kind, instruction) \
+    [opcode] = op_##opcode,
+
+OPCODE_LIST(DEFINE_HANDLER)
+
+const OpcodeHandler OPCODE_HANDLERS[0x100] = {
+    OPCODE_LIST(HANDLER_ENTRY)
+};
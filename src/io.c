@@ -1,53 +1,98 @@
 #include "../lib/io.h"
-#include "../lib/cpu.h"
 #include "../lib/cartridge.h"
+#include "../lib/tile_cache.h"
 
 #include <stdio.h>
 #include <stdbool.h>
-#include <SDL2/SDL.h>
 #include <stdint.h>
+#include <string.h>
 
-Color SYSTEM_PALETTE[sizeof(Color) * 64];
-uint8_t frame[FRAME_WIDTH * FRAME_HEIGHT * 3];
-
-// Returns true if program should stop
-bool handle_input(CPU *cpu, SDL_Event *event) {
-    while(SDL_PollEvent(event)) {
-        switch (event->type) {
-            case SDL_QUIT:
-                return true;
-            case SDL_KEYDOWN:
-                switch (event->key.keysym.sym) {
-                    case SDLK_UP:
-                        mem_write(cpu, 0x77, INPUT_ADDR);
-                        break;
-                    case SDLK_DOWN:
-                        mem_write(cpu, 0x73, INPUT_ADDR);
-                        break;
-                    case SDLK_LEFT:
-                        mem_write(cpu, 0x61, INPUT_ADDR);
-                        break;
-                    case SDLK_RIGHT:
-                        mem_write(cpu, 0x64, INPUT_ADDR);
-                        break;
-                    default:
-                        break;
-                }
-            default:
-                return false;
-        }
-    }
-    return false;
-}
+// x86 builds get the SSSE3 conversion even when the compiler may not assume SSSE3, it is picked at runtime
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#define SSSE3_FUNCTION static
+#define HAS_SSSE3 true
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SSSE3_FUNCTION static __attribute__((target("ssse3")))
+#define HAS_SSSE3 __builtin_cpu_supports("ssse3")
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Read-only, shared by every emulator instance
+const Color SYSTEM_PALETTE[64] = {
+    {0x80, 0x80, 0x80},
+    {0x00, 0x3D, 0xA6},
+    {0x00, 0x12, 0xB0},
+    {0x44, 0x00, 0x96},
+    {0xA1, 0x00, 0x5E},
+    {0xC7, 0x00, 0x28},
+    {0xBA, 0x06, 0x00},
+    {0x8C, 0x17, 0x00},
+    {0x5C, 0x2F, 0x00},
+    {0x10, 0x45, 0x00},
+    {0x05, 0x4A, 0x00},
+    {0x00, 0x47, 0x2E},
+    {0x00, 0x41, 0x66},
+    {0x00, 0x00, 0x00},
+    {0x05, 0x05, 0x05},
+    {0x05, 0x05, 0x05},
+    {0xC7, 0xC7, 0xC7},
+    {0x00, 0x77, 0xFF},
+    {0x21, 0x55, 0xFF},
+    {0x82, 0x37, 0xFA},
+    {0xEB, 0x2F, 0xB5},
+    {0xFF, 0x29, 0x50},
+    {0xFF, 0x22, 0x00},
+    {0xD6, 0x32, 0x00},
+    {0xC4, 0x62, 0x00},
+    {0x35, 0x80, 0x00},
+    {0x05, 0x8F, 0x00},
+    {0x00, 0x8A, 0x55},
+    {0x00, 0x99, 0xCC},
+    {0x21, 0x21, 0x21},
+    {0x09, 0x09, 0x09},
+    {0x09, 0x09, 0x09},
+    {0xFF, 0xFF, 0xFF},
+    {0x0F, 0xD7, 0xFF},
+    {0x69, 0xA2, 0xFF},
+    {0xD4, 0x80, 0xFF},
+    {0xFF, 0x45, 0xF3},
+    {0xFF, 0x61, 0x8B},
+    {0xFF, 0x88, 0x33},
+    {0xFF, 0x9C, 0x12},
+    {0xFA, 0xBC, 0x20},
+    {0x9F, 0xE3, 0x0E},
+    {0x2B, 0xF0, 0x35},
+    {0x0C, 0xF0, 0xA4},
+    {0x05, 0xFB, 0xFF},
+    {0x5E, 0x5E, 0x5E},
+    {0x0D, 0x0D, 0x0D},
+    {0x0D, 0x0D, 0x0D},
+    {0xFF, 0xFF, 0xFF},
+    {0xA6, 0xFC, 0xFF},
+    {0xB3, 0xEC, 0xFF},
+    {0xDA, 0xAB, 0xEB},
+    {0xFF, 0xA8, 0xF9},
+    {0xFF, 0xAB, 0xB3},
+    {0xFF, 0xD2, 0xB0},
+    {0xFF, 0xEF, 0xA6},
+    {0xFF, 0xF7, 0x9C},
+    {0xD7, 0xE8, 0x95},
+    {0xA6, 0xED, 0xAF},
+    {0xA2, 0xF2, 0xDA},
+    {0x99, 0xFF, 0xFC},
+    {0xDD, 0xDD, 0xDD},
+    {0x11, 0x11, 0x11},
+    {0x11, 0x11, 0x11},
+};
 
 // Colors pixel in frame array
-void draw_pixel(uint8_t *frame, int x, int y, Color color) {
-    int pixel = y * 3 * FRAME_WIDTH + x * 3;
+void draw_pixel(uint8_t *frame, int x, int y, uint8_t color) {
     // Checks if it's not out of bounds
-    if (pixel + 2 < FRAME_WIDTH * FRAME_HEIGHT * 3) {
-        frame[pixel] = color.r;
-        frame[pixel + 1] = color.g;
-        frame[pixel + 2] = color.b;
+    if (x >= 0 && x < FRAME_WIDTH && y >= 0 && y < FRAME_HEIGHT) {
+        frame[y * FRAME_WIDTH + x] = color;
     }
 }
 
@@ -64,35 +109,28 @@ void render_tiles(uint8_t *frame, uint8_t *chr_rom, int bank) {
             tile_x = 0;
         }
         int tile_lower_bound = bank + i * 16;
+        uint8_t pixels[TILE_PIXELS];
+        tile_decode(chr_rom + tile_lower_bound, pixels, false);
         for (int y = 0; y < 8; y ++) {
-
-            // Each pixel is represented by 2 bits in different bytes, 8 addresses apart
-            // Each tile is 16 bytes
-            uint8_t upper = chr_rom[tile_lower_bound + y];
-            uint8_t lower = chr_rom[tile_lower_bound + y + 8];
-
-            for (int x = 7; x >= 0; x--) {
-                uint8_t value = (upper & 1) << 1 | (lower & 1);
-                // "Consume" the bits to go to the next one
-                upper >>= 1;
-                lower >>= 1;
-                Color color;
+            for (int x = 0; x < 8; x++) {
+                uint8_t value = pixels[y * TILE_SIZE + x];
+                uint8_t color;
                 switch (value) {
                     case 0:
-                        color = SYSTEM_PALETTE[0x01];
+                        color = 0x01;
                         break;
                     case 1:
-                        color = SYSTEM_PALETTE[0x23];
+                        color = 0x23;
                         break;
                     case 2:
-                        color = SYSTEM_PALETTE[0x27];
+                        color = 0x27;
                         break;
                     case 3:
-                        color = SYSTEM_PALETTE[0x30];
+                        color = 0x30;
                         break;
                     default:
                         fprintf(stderr, "Impossible color wih value %i chosen at 'render_tile'.\n", value);
-                        color = (Color) {0, 0, 0};
+                        color = 0x0F;
                 }
                 draw_pixel(frame, tile_x + x, tile_y + y, color);
             }
@@ -101,6 +139,151 @@ void render_tiles(uint8_t *frame, uint8_t *chr_rom, int bank) {
     }
 }
 
+// Conversion functions
+
+// SYSTEM_PALETTE split into one table per channel, with a scanline's emphasis applied
+typedef struct ChannelTables {
+    _Alignas(16) uint8_t r[64];
+    _Alignas(16) uint8_t g[64];
+    _Alignas(16) uint8_t b[64];
+} ChannelTables;
+
+// Emphasis darkens the channels that aren't emphasized
+static void build_channel_tables(ChannelTables *tables, uint8_t emphasis) {
+    for (int i = 0; i < 64; i++) {
+        Color color = SYSTEM_PALETTE[i];
+        tables->r[i] = emphasis && !(emphasis & EMPHASIS_RED) ? color.r * 3 / 4 : color.r;
+        tables->g[i] = emphasis && !(emphasis & EMPHASIS_GREEN) ? color.g * 3 / 4 : color.g;
+        tables->b[i] = emphasis && !(emphasis & EMPHASIS_BLUE) ? color.b * 3 / 4 : color.b;
+    }
+}
+
+#if defined(SSSE3_FUNCTION)
+// Looks up 16 indices in a 64 entry table, 16 entries per shuffle
+SSSE3_FUNCTION inline __m128i lookup_64(const uint8_t *table, __m128i index) {
+    __m128i low = _mm_and_si128(index, _mm_set1_epi8(0x0F));
+    __m128i high = _mm_and_si128(_mm_srli_epi16(index, 4), _mm_set1_epi8(0x03));
+    __m128i result = _mm_setzero_si128();
+    for (int i = 0; i < 4; i++) {
+        __m128i entries = _mm_load_si128((const __m128i *) (table + i * 16));
+        __m128i selected = _mm_cmpeq_epi8(high, _mm_set1_epi8(i));
+        result = _mm_or_si128(result, _mm_and_si128(selected, _mm_shuffle_epi8(entries, low)));
+    }
+    return result;
+}
+
+// Converts the first pixels of a scanline 16 at a time, returns how many were converted
+SSSE3_FUNCTION int convert_scanline_ssse3(const uint8_t *line, const ChannelTables *tables, uint8_t *rgb, uint32_t *xrgb) {
+    int x = 0;
+    // Drops the 4th byte of each pixel
+    const __m128i pack_rgb = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    for (; x + 16 <= FRAME_WIDTH; x += 16) {
+        __m128i index = _mm_and_si128(_mm_loadu_si128((const __m128i *) (line + x)), _mm_set1_epi8(0x3F));
+        __m128i r = lookup_64(tables->r, index);
+        __m128i g = lookup_64(tables->g, index);
+        __m128i b = lookup_64(tables->b, index);
+        __m128i zero = _mm_setzero_si128();
+        if (rgb != NULL) {
+            __m128i rg_low = _mm_unpacklo_epi8(r, g);
+            __m128i rg_high = _mm_unpackhi_epi8(r, g);
+            __m128i b0_low = _mm_unpacklo_epi8(b, zero);
+            __m128i b0_high = _mm_unpackhi_epi8(b, zero);
+            __m128i pixels[4] = {
+                _mm_unpacklo_epi16(rg_low, b0_low),
+                _mm_unpackhi_epi16(rg_low, b0_low),
+                _mm_unpacklo_epi16(rg_high, b0_high),
+                _mm_unpackhi_epi16(rg_high, b0_high),
+            };
+            for (int i = 0; i < 4; i++) {
+                _Alignas(16) uint8_t packed[16];
+                _mm_store_si128((__m128i *) packed, _mm_shuffle_epi8(pixels[i], pack_rgb));
+                memcpy(rgb + (x + i * 4) * 3, packed, 12);
+            }
+        }
+        else {
+            // Little-endian 0x00RRGGBB is B, G, R, 0 in memory
+            __m128i bg_low = _mm_unpacklo_epi8(b, g);
+            __m128i bg_high = _mm_unpackhi_epi8(b, g);
+            __m128i r0_low = _mm_unpacklo_epi8(r, zero);
+            __m128i r0_high = _mm_unpackhi_epi8(r, zero);
+            _mm_storeu_si128((__m128i *) (xrgb + x), _mm_unpacklo_epi16(bg_low, r0_low));
+            _mm_storeu_si128((__m128i *) (xrgb + x + 4), _mm_unpackhi_epi16(bg_low, r0_low));
+            _mm_storeu_si128((__m128i *) (xrgb + x + 8), _mm_unpacklo_epi16(bg_high, r0_high));
+            _mm_storeu_si128((__m128i *) (xrgb + x + 12), _mm_unpackhi_epi16(bg_high, r0_high));
+        }
+    }
+    return x;
+}
+#endif
+
+// Converts one scanline of 6-bit indices, 16 pixels at a time where SIMD is available
+// Writes 3 bytes per pixel if 'rgb' isn't NULL, or 4 bytes per pixel into 'xrgb'
+static void convert_scanline(const uint8_t *line, const ChannelTables *tables, uint8_t *rgb, uint32_t *xrgb) {
+    int x = 0;
+#if defined(SSSE3_FUNCTION)
+    if (HAS_SSSE3) {
+        x = convert_scanline_ssse3(line, tables, rgb, xrgb);
+    }
+#elif defined(__aarch64__)
+    uint8x16x4_t r_table = vld1q_u8_x4(tables->r);
+    uint8x16x4_t g_table = vld1q_u8_x4(tables->g);
+    uint8x16x4_t b_table = vld1q_u8_x4(tables->b);
+    for (; x + 16 <= FRAME_WIDTH; x += 16) {
+        uint8x16_t index = vandq_u8(vld1q_u8(line + x), vdupq_n_u8(0x3F));
+        uint8x16_t r = vqtbl4q_u8(r_table, index);
+        uint8x16_t g = vqtbl4q_u8(g_table, index);
+        uint8x16_t b = vqtbl4q_u8(b_table, index);
+        if (rgb != NULL) {
+            uint8x16x3_t pixels = {{r, g, b}};
+            vst3q_u8(rgb + x * 3, pixels);
+        }
+        else {
+            uint8x16x4_t pixels = {{b, g, r, vdupq_n_u8(0)}};
+            vst4q_u8((uint8_t *) (xrgb + x), pixels);
+        }
+    }
+#endif
+    for (; x < FRAME_WIDTH; x++) {
+        uint8_t index = line[x] & 0x3F;
+        if (rgb != NULL) {
+            rgb[x * 3] = tables->r[index];
+            rgb[x * 3 + 1] = tables->g[index];
+            rgb[x * 3 + 2] = tables->b[index];
+        }
+        else {
+            xrgb[x] = (uint32_t) tables->r[index] << 16 | (uint32_t) tables->g[index] << 8 | tables->b[index];
+        }
+    }
+}
+
+// Converts a whole frame, tables are only rebuilt when the emphasis changes between scanlines
+static void convert_frame(const uint8_t *frame, uint8_t *rgb, uint32_t *xrgb) {
+    ChannelTables tables;
+    int emphasis = -1;
+    for (int y = 0; y < FRAME_HEIGHT; y++) {
+        if (frame[FRAME_EMPHASIS_OFFSET + y] != emphasis) {
+            emphasis = frame[FRAME_EMPHASIS_OFFSET + y];
+            build_channel_tables(&tables, emphasis);
+        }
+        convert_scanline(
+            frame + y * FRAME_WIDTH,
+            &tables,
+            rgb != NULL ? rgb + y * FRAME_WIDTH * 3 : NULL,
+            xrgb != NULL ? xrgb + y * FRAME_WIDTH : NULL
+        );
+    }
+}
+
+// Converts a frame to 3 bytes per pixel, red first
+void frame_to_rgb24(const uint8_t *frame, uint8_t *rgb) {
+    convert_frame(frame, rgb, NULL);
+}
+
+// Converts a frame to one 0x00RRGGBB word per pixel
+void frame_to_xrgb8888(const uint8_t *frame, uint32_t *xrgb) {
+    convert_frame(frame, NULL, xrgb);
+}
+
 // Color functions
 
 Color get_color(uint8_t byte) {
@@ -147,75 +330,3 @@ Color new_color(uint8_t red, uint8_t green, uint8_t blue) {
     color.b = blue;
     return color;
 }
-
-// Initializes the SYSTEM_PALETTE array
-void palette_initialize() {
-    Color temp_array[] = {
-        (Color) {0x80, 0x80, 0x80},
-        (Color) {0x00, 0x3D, 0xA6},
-        (Color) {0x00, 0x12, 0xB0},
-        (Color) {0x44, 0x00, 0x96},
-        (Color) {0xA1, 0x00, 0x5E},
-        (Color) {0xC7, 0x00, 0x28},
-        (Color) {0xBA, 0x06, 0x00},
-        (Color) {0x8C, 0x17, 0x00},
-        (Color) {0x5C, 0x2F, 0x00},
-        (Color) {0x10, 0x45, 0x00},
-        (Color) {0x05, 0x4A, 0x00},
-        (Color) {0x00, 0x47, 0x2E},
-        (Color) {0x00, 0x41, 0x66},
-        (Color) {0x00, 0x00, 0x00},
-        (Color) {0x05, 0x05, 0x05},
-        (Color) {0x05, 0x05, 0x05},
-        (Color) {0xC7, 0xC7, 0xC7},
-        (Color) {0x00, 0x77, 0xFF},
-        (Color) {0x21, 0x55, 0xFF},
-        (Color) {0x82, 0x37, 0xFA},
-        (Color) {0xEB, 0x2F, 0xB5},
-        (Color) {0xFF, 0x29, 0x50},
-        (Color) {0xFF, 0x22, 0x00},
-        (Color) {0xD6, 0x32, 0x00},
-        (Color) {0xC4, 0x62, 0x00},
-        (Color) {0x35, 0x80, 0x00},
-        (Color) {0x05, 0x8F, 0x00},
-        (Color) {0x00, 0x8A, 0x55},
-        (Color) {0x00, 0x99, 0xCC},
-        (Color) {0x21, 0x21, 0x21},
-        (Color) {0x09, 0x09, 0x09},
-        (Color) {0x09, 0x09, 0x09},
-        (Color) {0xFF, 0xFF, 0xFF},
-        (Color) {0x0F, 0xD7, 0xFF},
-        (Color) {0x69, 0xA2, 0xFF},
-        (Color) {0xD4, 0x80, 0xFF},
-        (Color) {0xFF, 0x45, 0xF3},
-        (Color) {0xFF, 0x61, 0x8B},
-        (Color) {0xFF, 0x88, 0x33},
-        (Color) {0xFF, 0x9C, 0x12},
-        (Color) {0xFA, 0xBC, 0x20},
-        (Color) {0x9F, 0xE3, 0x0E},
-        (Color) {0x2B, 0xF0, 0x35},
-        (Color) {0x0C, 0xF0, 0xA4},
-        (Color) {0x05, 0xFB, 0xFF},
-        (Color) {0x5E, 0x5E, 0x5E},
-        (Color) {0x0D, 0x0D, 0x0D},
-        (Color) {0x0D, 0x0D, 0x0D},
-        (Color) {0xFF, 0xFF, 0xFF},
-        (Color) {0xA6, 0xFC, 0xFF},
-        (Color) {0xB3, 0xEC, 0xFF},
-        (Color) {0xDA, 0xAB, 0xEB},
-        (Color) {0xFF, 0xA8, 0xF9},
-        (Color) {0xFF, 0xAB, 0xB3},
-        (Color) {0xFF, 0xD2, 0xB0},
-        (Color) {0xFF, 0xEF, 0xA6},
-        (Color) {0xFF, 0xF7, 0x9C},
-        (Color) {0xD7, 0xE8, 0x95},
-        (Color) {0xA6, 0xED, 0xAF},
-        (Color) {0xA2, 0xF2, 0xDA},
-        (Color) {0x99, 0xFF, 0xFC},
-        (Color) {0xDD, 0xDD, 0xDD},
-        (Color) {0x11, 0x11, 0x11},
-        (Color) {0x11, 0x11, 0x11},
-    };
-
-    memcpy(SYSTEM_PALETTE, temp_array, sizeof(temp_array));
-}
@@ -0,0 +1,47 @@
+#include "../lib/joypad.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+Joypad joypad_new(void) {
+    Joypad joypad;
+    joypad.buttons = 0;
+    joypad.button_index = 0;
+    joypad.strobe = false;
+    return joypad;
+}
+
+// Writing 1 keeps the shift register reloading from the buttons
+// Writing 0 lets reads shift through them
+void joypad_write(Joypad *joypad, uint8_t value) {
+    joypad->strobe = (value & 1) != 0;
+    if (joypad->strobe) {
+        joypad->button_index = 0;
+    }
+}
+
+// Returns the next button's state in bit 0
+// Reads after all 8 buttons return 1, like official controllers
+uint8_t joypad_read(Joypad *joypad) {
+    if (joypad->button_index > 7) {
+        return 1;
+    }
+    uint8_t value = (joypad->buttons >> joypad->button_index) & 1;
+    if (!joypad->strobe) {
+        joypad->button_index++;
+    }
+    return value;
+}
+
+void joypad_set_buttons(Joypad *joypad, uint8_t buttons) {
+    joypad->buttons = buttons;
+}
+
+void joypad_button_set(Joypad *joypad, uint8_t button, bool pressed) {
+    if (pressed) {
+        joypad->buttons |= button;
+    }
+    else {
+        joypad->buttons &= ~button;
+    }
+}
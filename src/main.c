@@ -1,7 +1,10 @@
+#include "../lib/nes.h"
 #include "../lib/cpu.h"
 #include "../lib/instructions.h"
 #include "../lib/io.h"
 #include "../lib/cartridge.h"
+#include "../lib/bus.h"
+#include "../lib/frontend.h"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_events.h>
@@ -9,18 +12,32 @@
 #include <SDL2/SDL_timer.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 int main(int argc, char **argv) {
-    if (argc > 2) {
-        fprintf(stderr, "Too many arguments provided. Expected 1, received %i.\n", argc - 1);
+    // Usage: nes_emulator [-v | -vv] <file.nes>
+    // '-v' reports unhandled memory accesses, '-vv' also lists their addresses
+    int verbosity = 0;
+    int rom_arg = 1;
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+        verbosity = 1;
+        rom_arg = 2;
+    }
+    else if (argc > 1 && strcmp(argv[1], "-vv") == 0) {
+        verbosity = 2;
+        rom_arg = 2;
+    }
+
+    if (argc > rom_arg + 1) {
+        fprintf(stderr, "Too many arguments provided. Expected %i, received %i.\n", rom_arg, argc - 1);
         return 1;
     }
-    else if (argc < 2) {
-        fprintf(stderr, "Too few arguments provided. Expected 1, received %i.\n", argc - 1);
+    else if (argc < rom_arg + 1) {
+        fprintf(stderr, "Too few arguments provided. Expected %i, received %i.\n", rom_arg, argc - 1);
         return 1;
     }
 
-    ROM *rom = get_rom(argv[1]);
+    ROM *rom = get_rom(argv[rom_arg]);
     if (rom == NULL) {
         return 1;
     }
@@ -72,7 +89,7 @@ int main(int argc, char **argv) {
 
     SDL_Texture *texture = SDL_CreateTexture(
         renderer,
-        SDL_PIXELFORMAT_RGB24,
+        SDL_PIXELFORMAT_RGB888,
         SDL_TEXTUREACCESS_TARGET,
         FRAME_WIDTH,
         FRAME_HEIGHT
@@ -86,13 +103,24 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    palette_initialize();
-    render_tiles(frame, rom->chr_rom, 0);
-    CPU *cpu = new_cpu(rom);
-    populate_inst_list();
-    //load(cpu);
-    reset(cpu);
-    run(cpu, renderer, texture);
+    NES *nes = nes_new(rom);
+    if (nes == NULL) {
+        SDL_DestroyTexture(texture);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    if (rom->chr_rom != NULL) {
+        render_tiles(nes->frame, rom->chr_rom, 0);
+    }
+    nes->bus->diagnostics.verbosity = verbosity;
+    //load(nes->cpu);
+    nes_reset(nes);
+    run(nes, renderer, texture);
+    if (verbosity > 0) {
+        diagnostics_report(&nes->bus->diagnostics, stderr);
+    }
     
     /*
 
@@ -136,7 +164,7 @@ int main(int argc, char **argv) {
     
     */
     // Cleanup
-    destroy_cpu(cpu);
+    nes_destroy(nes);
     SDL_DestroyTexture(texture);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
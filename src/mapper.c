@@ -0,0 +1,413 @@
+#include "../lib/mapper.h"
+#include "../lib/bus.h"
+#include "../lib/ppu.h"
+#include "../lib/cartridge.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define CHR_BANK_2K 0x800
+#define CHR_BANK_4K 0x1000
+#define CHR_BANK_8K 0x2000
+
+#define MMC1_SHIFT_RESET 0x10
+
+// Bank mapping functions
+
+// Maps PRG ROM bank 'bank', counted in units of 'size', at 'addr'
+// Bank numbers past the end of the ROM wrap around, ROMs smaller than 'size' are mirrored across it
+static void map_prg(Bus *bus, uint16_t addr, int size, int bank) {
+    ROM *rom = bus->rom;
+    if (rom->prg_rom_length == 0) {
+        return;
+    }
+    if (rom->prg_rom_length < size) {
+        for (int offset = 0; offset < size; offset += rom->prg_rom_length) {
+            bus_map_memory(bus, addr + offset, rom->prg_rom_length, rom->prg_rom, false);
+        }
+        return;
+    }
+    int banks = rom->prg_rom_length / size;
+    bank %= banks;
+    if (bank < 0) {
+        bank += banks;
+    }
+    bus_map_memory(bus, addr, size, rom->prg_rom + bank * size, false);
+}
+
+// Returns the number of the last PRG ROM bank of 'size' bytes
+static int last_prg_bank(Bus *bus, int size) {
+    int banks = bus->rom->prg_rom_length / size;
+    return banks > 0 ? banks - 1 : 0;
+}
+
+// Maps CHR bank 'bank', counted in units of 'size', at pattern address 'addr'
+// Carts without CHR ROM have CHR RAM, which is banked the same way
+// Pattern memory smaller than 'size' is mirrored across it
+static void map_chr(Bus *bus, uint16_t addr, int size, int bank) {
+    ROM *rom = bus->rom;
+    uint8_t *chr = rom->chr_rom_length > 0 ? rom->chr_rom : bus->mapper.chr_ram;
+    int length = rom->chr_rom_length > 0 ? rom->chr_rom_length : bus->mapper.chr_ram_length;
+    if (length < size) {
+        for (int offset = 0; offset < size; offset += length) {
+            int count = (size - offset < length ? size - offset : length) / CHR_BANK_SIZE;
+            ppu_map_chr(bus->ppu, (addr + offset) / CHR_BANK_SIZE, chr, count);
+        }
+        return;
+    }
+    bank %= length / size;
+    ppu_map_chr(bus->ppu, addr / CHR_BANK_SIZE, chr + bank * size, size / CHR_BANK_SIZE);
+}
+
+// Maps PRG RAM at $6000, mirrored if there is less than the window holds
+// None of the supported boards bank PRG RAM, so only the first 8 kB are ever visible
+static void map_prg_ram(Bus *bus) {
+    Mapper *mapper = &bus->mapper;
+    if (mapper->prg_ram == NULL) {
+        return;
+    }
+    for (int offset = 0; offset < PRG_RAM_SIZE; offset += mapper->prg_ram_length) {
+        int size = PRG_RAM_SIZE - offset < mapper->prg_ram_length ? PRG_RAM_SIZE - offset : mapper->prg_ram_length;
+        bus_map_memory(bus, PRG_RAM_START + offset, size, mapper->prg_ram, true);
+    }
+}
+
+// NROM (0)
+// 16 or 32 kB of PRG ROM and 8 kB of CHR, no registers
+
+static void nrom_reset(Bus *bus) {
+    map_prg(bus, PRG_ROM_START, PRG_BANK_32K, 0);
+    map_chr(bus, 0x0000, CHR_BANK_8K, 0);
+}
+
+// MMC1 (1)
+
+// Mirroring selected by the low 2 bits of the control register
+static const Mirroring MMC1_MIRRORING[4] = {SingleScreenLower, SingleScreenUpper, Vertical, Horizontal};
+
+static void mmc1_update(Bus *bus) {
+    MMC1 *mmc1 = &bus->mapper.state.mmc1;
+    ppu_set_mirroring(bus->ppu, MMC1_MIRRORING[mmc1->control & 0b11]);
+
+    // CHR is switched as a whole 8 kB or as two 4 kB banks
+    if (mmc1->control & 0b10000) {
+        map_chr(bus, 0x0000, CHR_BANK_4K, mmc1->chr_bank_0);
+        map_chr(bus, 0x1000, CHR_BANK_4K, mmc1->chr_bank_1);
+    }
+    else {
+        map_chr(bus, 0x0000, CHR_BANK_8K, mmc1->chr_bank_0 >> 1);
+    }
+
+    // 512 kB boards select the 256 kB half of PRG ROM with bit 4 of the first CHR register
+    int outer = bus->rom->prg_rom_length > 0x40000 ? mmc1->chr_bank_0 & 0x10 : 0;
+    int bank = outer | (mmc1->prg_bank & 0x0F);
+    switch ((mmc1->control >> 2) & 0b11) {
+        case 0:
+        case 1:
+            map_prg(bus, 0x8000, PRG_BANK_32K, bank >> 1);
+            break;
+        case 2:
+            // First bank fixed at $8000
+            map_prg(bus, 0x8000, PRG_BANK_16K, outer);
+            map_prg(bus, 0xC000, PRG_BANK_16K, bank);
+            break;
+        case 3:
+            // Last bank fixed at $C000
+            map_prg(bus, 0x8000, PRG_BANK_16K, bank);
+            map_prg(bus, 0xC000, PRG_BANK_16K, outer | 0x0F);
+            break;
+    }
+}
+
+static void mmc1_reset(Bus *bus) {
+    MMC1 *mmc1 = &bus->mapper.state.mmc1;
+    mmc1->shift = MMC1_SHIFT_RESET;
+    mmc1->control = 0x0C;
+    mmc1->chr_bank_0 = 0;
+    mmc1->chr_bank_1 = 0;
+    mmc1->prg_bank = 0;
+    mmc1_update(bus);
+}
+
+// Bit 7 resets the shift register, otherwise bit 0 is shifted in
+// The fifth write loads the register selected by address bits 13 and 14
+// Not emulated: the chip ignores a write on the cycle after another, which read-modify-write instructions
+// cause. The CPU skips their dummy write, so an INC on a $FF byte of ROM shifts a 0 in instead of resetting
+static void mmc1_write(Bus *bus, uint16_t addr, uint8_t value) {
+    MMC1 *mmc1 = &bus->mapper.state.mmc1;
+    if (value & 0x80) {
+        mmc1->shift = MMC1_SHIFT_RESET;
+        mmc1->control |= 0x0C;
+        mmc1_update(bus);
+        return;
+    }
+
+    bool complete = mmc1->shift & 1;
+    mmc1->shift = (mmc1->shift >> 1) | ((value & 1) << 4);
+    if (!complete) {
+        return;
+    }
+    switch ((addr >> 13) & 0b11) {
+        case 0:
+            mmc1->control = mmc1->shift;
+            break;
+        case 1:
+            mmc1->chr_bank_0 = mmc1->shift;
+            break;
+        case 2:
+            mmc1->chr_bank_1 = mmc1->shift;
+            break;
+        case 3:
+            mmc1->prg_bank = mmc1->shift;
+            break;
+    }
+    mmc1->shift = MMC1_SHIFT_RESET;
+    mmc1_update(bus);
+}
+
+// UxROM (2)
+// Switches 16 kB at $8000, the last bank is fixed at $C000
+
+static void uxrom_reset(Bus *bus) {
+    bus->mapper.state.bank = 0;
+    map_prg(bus, 0x8000, PRG_BANK_16K, 0);
+    map_prg(bus, 0xC000, PRG_BANK_16K, last_prg_bank(bus, PRG_BANK_16K));
+    map_chr(bus, 0x0000, CHR_BANK_8K, 0);
+}
+
+static void uxrom_write(Bus *bus, uint16_t addr, uint8_t value) {
+    (void) addr; // The register answers anywhere in $8000-$FFFF
+    bus->mapper.state.bank = value;
+    map_prg(bus, 0x8000, PRG_BANK_16K, value);
+}
+
+// CNROM (3)
+// Switches all 8 kB of CHR
+
+static void cnrom_reset(Bus *bus) {
+    bus->mapper.state.bank = 0;
+    map_prg(bus, PRG_ROM_START, PRG_BANK_32K, 0);
+    map_chr(bus, 0x0000, CHR_BANK_8K, 0);
+}
+
+static void cnrom_write(Bus *bus, uint16_t addr, uint8_t value) {
+    (void) addr;
+    bus->mapper.state.bank = value;
+    map_chr(bus, 0x0000, CHR_BANK_8K, value);
+}
+
+// MMC3 (4)
+
+static void mmc3_update(Bus *bus) {
+    MMC3 *mmc3 = &bus->mapper.state.mmc3;
+    int second_last = last_prg_bank(bus, PRG_BANK_8K) - 1;
+
+    // Bit 6 swaps the switchable bank at $8000 with the fixed one at $C000
+    if (mmc3->bank_select & 0x40) {
+        map_prg(bus, 0x8000, PRG_BANK_8K, second_last);
+        map_prg(bus, 0xC000, PRG_BANK_8K, mmc3->banks[6]);
+    }
+    else {
+        map_prg(bus, 0x8000, PRG_BANK_8K, mmc3->banks[6]);
+        map_prg(bus, 0xC000, PRG_BANK_8K, second_last);
+    }
+    map_prg(bus, 0xA000, PRG_BANK_8K, mmc3->banks[7]);
+    map_prg(bus, 0xE000, PRG_BANK_8K, last_prg_bank(bus, PRG_BANK_8K));
+
+    // Bit 7 swaps the two 2 kB banks with the four 1 kB ones
+    uint16_t inversion = mmc3->bank_select & 0x80 ? 0x1000 : 0;
+    map_chr(bus, 0x0000 ^ inversion, CHR_BANK_2K, mmc3->banks[0] >> 1);
+    map_chr(bus, 0x0800 ^ inversion, CHR_BANK_2K, mmc3->banks[1] >> 1);
+    for (int i = 0; i < 4; i++) {
+        map_chr(bus, (0x1000 + i * CHR_BANK_SIZE) ^ inversion, CHR_BANK_SIZE, mmc3->banks[2 + i]);
+    }
+}
+
+static void mmc3_reset(Bus *bus) {
+    MMC3 *mmc3 = &bus->mapper.state.mmc3;
+    // Distinct banks until the game sets them up
+    static const uint8_t POWER_UP_BANKS[8] = {0, 2, 4, 5, 6, 7, 0, 1};
+    memset(mmc3, 0, sizeof(MMC3));
+    memcpy(mmc3->banks, POWER_UP_BANKS, sizeof(mmc3->banks));
+    mmc3_update(bus);
+}
+
+// Registers are selected by the address range and whether the address is even or odd
+static void mmc3_write(Bus *bus, uint16_t addr, uint8_t value) {
+    MMC3 *mmc3 = &bus->mapper.state.mmc3;
+    bool odd = addr & 1;
+    switch (addr & 0xE000) {
+        case 0x8000:
+            if (odd) {
+                mmc3->banks[mmc3->bank_select & 0b111] = value;
+            }
+            else {
+                mmc3->bank_select = value;
+            }
+            mmc3_update(bus);
+            break;
+        case 0xA000:
+            // Odd addresses protect PRG RAM, which isn't emulated
+            if (!odd && bus->rom->mirroring != FourScreen) {
+                ppu_set_mirroring(bus->ppu, value & 1 ? Horizontal : Vertical);
+            }
+            break;
+        case 0xC000:
+            if (odd) {
+                mmc3->irq_counter = 0;
+                mmc3->irq_reload = true;
+            }
+            else {
+                mmc3->irq_latch = value;
+            }
+            break;
+        case 0xE000:
+            // Even addresses also acknowledge a pending IRQ
+            mmc3->irq_enabled = odd;
+            if (!odd) {
+                bus->mapper.irq = false;
+            }
+            break;
+    }
+}
+
+// The counter reloads when it's at 0 or a reload was requested, and raises an IRQ whenever it ends up at 0
+static void mmc3_a12_clock(Mapper *mapper) {
+    MMC3 *mmc3 = &mapper->state.mmc3;
+    if (mmc3->irq_counter == 0 || mmc3->irq_reload) {
+        mmc3->irq_counter = mmc3->irq_latch;
+        mmc3->irq_reload = false;
+    }
+    else {
+        mmc3->irq_counter--;
+    }
+    if (mmc3->irq_counter == 0 && mmc3->irq_enabled) {
+        mapper->irq = true;
+    }
+}
+
+static int mmc3_a12_clocks_until_irq(Mapper *mapper) {
+    MMC3 *mmc3 = &mapper->state.mmc3;
+    if (!mmc3->irq_enabled || mapper->irq) {
+        return 0;
+    }
+    if (mmc3->irq_counter == 0 || mmc3->irq_reload) {
+        return mmc3->irq_latch + 1;
+    }
+    return mmc3->irq_counter;
+}
+
+// AxROM (7)
+// Switches all 32 kB of PRG, bit 4 selects which nametable fills the screen
+
+static void axrom_reset(Bus *bus) {
+    bus->mapper.state.bank = 0;
+    map_prg(bus, PRG_ROM_START, PRG_BANK_32K, 0);
+    map_chr(bus, 0x0000, CHR_BANK_8K, 0);
+    ppu_set_mirroring(bus->ppu, SingleScreenLower);
+}
+
+static void axrom_write(Bus *bus, uint16_t addr, uint8_t value) {
+    (void) addr;
+    bus->mapper.state.bank = value;
+    map_prg(bus, PRG_ROM_START, PRG_BANK_32K, value & 0b111);
+    ppu_set_mirroring(bus->ppu, value & 0x10 ? SingleScreenUpper : SingleScreenLower);
+}
+
+typedef struct MapperInfo {
+    int number;
+    void (*reset)(Bus *bus);
+    void (*write)(Bus *bus, uint16_t addr, uint8_t value);
+    void (*a12_clock)(Mapper *mapper);
+    int (*a12_clocks_until_irq)(Mapper *mapper);
+} MapperInfo;
+
+static const MapperInfo MAPPERS[] = {
+    {0, nrom_reset, NULL, NULL, NULL},
+    {1, mmc1_reset, mmc1_write, NULL, NULL},
+    {2, uxrom_reset, uxrom_write, NULL, NULL},
+    {3, cnrom_reset, cnrom_write, NULL, NULL},
+    {4, mmc3_reset, mmc3_write, mmc3_a12_clock, mmc3_a12_clocks_until_irq},
+    {7, axrom_reset, axrom_write, NULL, NULL},
+};
+
+#define MAPPER_COUNT (sizeof(MAPPERS) / sizeof(MAPPERS[0]))
+
+static const MapperInfo *find_mapper(int number) {
+    for (unsigned int i = 0; i < MAPPER_COUNT; i++) {
+        if (MAPPERS[i].number == number) {
+            return &MAPPERS[i];
+        }
+    }
+    return NULL;
+}
+
+bool mapper_supported(int number) {
+    return find_mapper(number) != NULL;
+}
+
+// Cart RAM is rounded up to the units the bus and the PPU map
+
+static int round_up(int length, int unit) {
+    return (length + unit - 1) / unit * unit;
+}
+
+static int prg_ram_length(const ROM *rom) {
+    return round_up(rom->prg_ram_length + rom->prg_nvram_length, BUS_PAGE_SIZE);
+}
+
+static int chr_ram_length(const ROM *rom) {
+    if (rom->chr_rom_length > 0) {
+        return 0;
+    }
+    // Headers that give neither CHR ROM nor CHR RAM get the iNES 1.0 default
+    int length = rom->chr_ram_length + rom->chr_nvram_length;
+    return round_up(length > 0 ? length : CHR_RAM_DEFAULT_SIZE, CHR_BANK_SIZE);
+}
+
+// Returns how many bytes of cart RAM 'rom' needs, PRG RAM followed by CHR RAM
+size_t mapper_memory_size(const ROM *rom) {
+    return prg_ram_length(rom) + chr_ram_length(rom);
+}
+
+// Puts the cartridge hardware in its power-up state and maps its memory into the bus and the PPU
+// The PPU must already be initialized with 'rom', which must fit in the mapper's memory
+void mapper_init(Bus *bus, ROM *rom) {
+    const MapperInfo *info = find_mapper(rom->mapper);
+    if (info == NULL) {
+        // get_rom() rejects these, so this only happens with hand-built ROMs
+        info = find_mapper(0);
+    }
+    Mapper *mapper = &bus->mapper;
+    mapper->number = info->number;
+    mapper->write = info->write;
+    mapper->a12_clock = info->a12_clock;
+    mapper->a12_clocks_until_irq = info->a12_clocks_until_irq;
+    mapper->irq = false;
+    // The PPU only tracks A12 for boards that watch it
+    bus->ppu->mapper = info->a12_clock != NULL ? mapper : NULL;
+
+    // PRG RAM comes first in the mapper's memory, then CHR RAM
+    mapper->prg_ram_length = prg_ram_length(rom);
+    mapper->chr_ram_length = chr_ram_length(rom);
+    mapper->prg_ram = mapper->prg_ram_length > 0 ? mapper->memory : NULL;
+    mapper->chr_ram = mapper->chr_ram_length > 0 ? mapper->memory + mapper->prg_ram_length : NULL;
+    memset(mapper->memory, 0, mapper->prg_ram_length + mapper->chr_ram_length);
+    map_prg_ram(bus);
+    info->reset(bus);
+}
+
+// Passes a write to $8000-$FFFF to the mapper
+// Returns false if the mapper has no registers
+bool mapper_write(Bus *bus, uint16_t addr, uint8_t value) {
+    if (bus->mapper.write == NULL) {
+        return false;
+    }
+    // Bank switches change what the PPU draws from here on
+    ppu_sync(bus->ppu);
+    bus->mapper.write(bus, addr, value);
+    // The write may have changed when the next sprite 0 hit or IRQ is due
+    ppu_reschedule(bus->ppu);
+    return true;
+}
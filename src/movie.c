@@ -0,0 +1,65 @@
+#include "../lib/movie.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define MOVIE_LINE_LENGTH 256
+
+Movie *movie_load(const char *file_path) {
+    FILE *file = fopen(file_path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Couldn't open movie '%s'.\n", file_path);
+        return NULL;
+    }
+
+    Movie *movie = malloc(sizeof(Movie));
+    int capacity = 1024;
+    movie->pad_1 = malloc(capacity);
+    movie->pad_2 = malloc(capacity);
+    movie->length = 0;
+
+    char line[MOVIE_LINE_LENGTH];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] != '|') {
+            continue;
+        }
+        // Skips the commands field
+        char *pad_1 = strchr(line + 1, '|');
+        if (pad_1 == NULL) {
+            continue;
+        }
+        pad_1++;
+        char *pad_2 = strchr(pad_1, '|');
+
+        if (movie->length == capacity) {
+            capacity *= 2;
+            movie->pad_1 = realloc(movie->pad_1, capacity);
+            movie->pad_2 = realloc(movie->pad_2, capacity);
+        }
+        movie->pad_1[movie->length] = movie_parse_buttons(pad_1);
+        movie->pad_2[movie->length] = pad_2 != NULL ? movie_parse_buttons(pad_2 + 1) : 0;
+        movie->length++;
+    }
+
+    fclose(file);
+    return movie;
+}
+
+void movie_destroy(Movie *movie) {
+    free(movie->pad_1);
+    free(movie->pad_2);
+    free(movie);
+}
+
+// Converts a "RLDUTSBA" field into joypad button bits
+uint8_t movie_parse_buttons(const char *field) {
+    uint8_t buttons = 0;
+    for (int i = 0; i < 8 && strchr("|\r\n", field[i]) == NULL; i++) {
+        if (field[i] != '.' && field[i] != ' ') {
+            buttons |= 0b10000000 >> i;
+        }
+    }
+    return buttons;
+}
@@ -0,0 +1,114 @@
+#include "../lib/nes.h"
+#include "../lib/cpu.h"
+#include "../lib/bus.h"
+#include "../lib/ppu.h"
+#include "../lib/cartridge.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// Rounds the pieces of a console's arena up so each one starts on its own cache line
+static size_t arena_align(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+// The Windows C runtime has no aligned_alloc(), its aligned blocks need a free function of their own
+static void *arena_alloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, ARENA_ALIGNMENT);
+#else
+    return aligned_alloc(ARENA_ALIGNMENT, size);
+#endif
+}
+
+static void arena_free(void *arena) {
+#if defined(_WIN32)
+    _aligned_free(arena);
+#else
+    free(arena);
+#endif
+}
+
+// Instantiates a new console
+// Takes over a reference to 'rom', which is released by 'nes_destroy()'
+// Use rom_retain() to run the same ROM on several consoles
+// Returns NULL if the console couldn't be allocated, the reference to 'rom' is released then
+NES *nes_new(ROM *rom) {
+    // One allocation holds the console and the cart RAM 'rom' asks for
+    size_t cart_memory_size = mapper_memory_size(rom);
+    size_t size = arena_align(sizeof(NES)) + arena_align(sizeof(CPU)) + arena_align(sizeof(Bus))
+        + arena_align(sizeof(PPU)) + arena_align(cart_memory_size);
+    uint8_t *arena = arena_alloc(size);
+    if (arena == NULL) {
+        fprintf(stderr, "Couldn't allocate a console.\n");
+        free_rom(rom);
+        return NULL;
+    }
+    NES *nes = (NES *) arena;
+    arena += arena_align(sizeof(NES));
+    nes->cpu = (CPU *) arena;
+    arena += arena_align(sizeof(CPU));
+    nes->bus = (Bus *) arena;
+    arena += arena_align(sizeof(Bus));
+    nes->ppu = (PPU *) arena;
+    arena += arena_align(sizeof(PPU));
+
+    ppu_create(nes->ppu, rom);
+    bus_create(nes->bus, nes->ppu, arena, cart_memory_size, rom);
+    cpu_create(nes->cpu, nes->bus);
+    nes->rom = rom;
+    memset(nes->frame, 0, sizeof(nes->frame));
+    nes->ppu->frame = nes->frame;
+    return nes;
+}
+
+void nes_destroy(NES *nes) {
+    free_rom(nes->rom);
+    diagnostics_destroy(&nes->bus->diagnostics);
+    arena_free(nes);
+}
+
+// Swaps the cartridge and powers the console back on, reusing every allocation
+// Takes over a reference to 'rom' and releases the previous ROM's, unless it is 'rom' itself
+// Returns false if 'rom' needs more cart RAM than the console was built with, nothing changes then
+bool nes_load(NES *nes, ROM *rom) {
+    if (mapper_memory_size(rom) > nes->bus->mapper.memory_size) {
+        return false;
+    }
+    if (nes->rom != rom) {
+        free_rom(nes->rom);
+        nes->rom = rom;
+    }
+    bus_load_rom(nes->bus, rom);
+    set_status(nes->cpu, 0);
+    nes->cpu->program_counter = 0;
+    nes->cpu->stack_pointer = STACK_RESET;
+    memset(nes->frame, 0, sizeof(nes->frame));
+    return true;
+}
+
+void nes_reset(NES *nes) {
+    reset(nes->cpu);
+}
+
+// Runs until the PPU finishes a frame
+// Returns false if the program stopped
+bool nes_run_frame(NES *nes) {
+    return run_frame(nes->cpu);
+}
+
+// Skips drawing 'skip_frames' out of every 'skip_period' frames
+// Game logic isn't affected, only the pixels are left out
+void nes_set_frame_skip(NES *nes, int skip_frames, int skip_period) {
+    ppu_set_frame_skip(nes->ppu, skip_frames, skip_period);
+}
+
+// Returns true if the last frame run was drawn into 'frame'
+bool nes_frame_drawn(NES *nes) {
+    return ppu_frame_drawn(nes->ppu);
+}
@@ -0,0 +1,98 @@
+#include "../lib/batch.h"
+#include "../lib/rom_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Runs every job of a manifest across a pool of workers
+// Usage: nes_batch [-j WORKERS] [-D DATABASE] <manifest>
+//   -j WORKERS   Number of worker threads (default: one per core)
+//   -D DATABASE  ROM database, read before the run and written back with every ROM it loaded
+
+void print_usage(void) {
+    fprintf(stderr, "Usage: nes_batch [-j WORKERS] [-D DATABASE] <manifest>\n");
+}
+
+int main(int argc, char **argv) {
+    int worker_count = 0;
+    char *manifest_path = NULL;
+    char *database_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            worker_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            database_path = argv[++i];
+        }
+        else if (argv[i][0] != '-' && manifest_path == NULL) {
+            manifest_path = argv[i];
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (manifest_path == NULL) {
+        print_usage();
+        return 1;
+    }
+
+    if (database_path != NULL && !rom_cache_load_database(database_path)) {
+        return 1;
+    }
+    Batch *batch = batch_load_manifest(manifest_path);
+    if (batch == NULL) {
+        return 1;
+    }
+    if (!batch_run(batch, worker_count)) {
+        batch_destroy(batch);
+        return 1;
+    }
+    if (database_path != NULL) {
+        rom_cache_save_database(database_path);
+    }
+
+    int failed = 0;
+    long total_frames = 0;
+    for (int i = 0; i < batch->job_count; i++) {
+        BatchJob *job = &batch->jobs[i];
+        BatchResult *result = &batch->results[i];
+        if (!result->success) {
+            printf("%i %s FAILED\n", i, job->rom_path);
+            failed++;
+            continue;
+        }
+        printf("%i %s frames=%i%s ram=%016llX frame=%016llX\n",
+            i,
+            job->rom_path,
+            result->frames,
+            result->stopped ? " (stopped)" : "",
+            (unsigned long long) result->ram_hash,
+            (unsigned long long) result->frame_hash
+        );
+        total_frames += result->frames;
+    }
+
+    for (int i = 0; i < batch->worker_count; i++) {
+        BatchWorkerStats *stats = &batch->workers[i];
+        printf("Worker %i: %i jobs, %li frames, %.1f frames/s\n",
+            i,
+            stats->jobs,
+            stats->frames,
+            stats->seconds > 0 ? stats->frames / stats->seconds : 0.0
+        );
+    }
+    printf("Total: %i jobs, %li frames in %.2f s, %.1f frames/s\n",
+        batch->job_count,
+        total_frames,
+        batch->seconds,
+        batch->seconds > 0 ? total_frames / batch->seconds : 0.0
+    );
+
+    batch_destroy(batch);
+    rom_cache_clear();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+#include "../lib/nes.h"
+#include "../lib/cpu.h"
+#include "../lib/bus.h"
+#include "../lib/io.h"
+#include "../lib/cartridge.h"
+#include "../lib/headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Runs a ROM with no window, input or pacing
+// Usage: nes_headless [options] <file.nes>
+//   -f FRAMES       Frames to run (default: until the program stops)
+//   -u ADDR=VALUE   Stops once the RAM byte at ADDR ($0000-$1FFF) equals VALUE (both hex)
+//   -d DIR          Dumps every frame to DIR as PPM images
+//   -H              Prints a hash of every frame
+//   -k SKIP/PERIOD  Doesn't draw SKIP out of every PERIOD frames
+//   -v, -vv         Reports unhandled memory accesses
+
+void print_usage(void) {
+    fprintf(stderr, "Usage: nes_headless [-f FRAMES] [-u ADDR=VALUE] [-d DIR] [-H] [-k SKIP/PERIOD] [-v | -vv] <file.nes>\n");
+}
+
+int main(int argc, char **argv) {
+    HeadlessOptions options = headless_options_new();
+    int verbosity = 0;
+    char *rom_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            options.frames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            unsigned int addr;
+            unsigned int value;
+            if (sscanf(argv[++i], "%x=%x", &addr, &value) != 2 || addr > RAM_MIRROR_END || value > 0xFF) {
+                fprintf(stderr, "Invalid condition '%s'. Expected ADDR=VALUE in hex, with ADDR in RAM (0-1FFF).\n", argv[i]);
+                return 1;
+            }
+            options.until_addr = addr;
+            options.until_value = value;
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            options.dump_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-H") == 0) {
+            options.print_hashes = true;
+        }
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%i/%i", &options.skip_frames, &options.skip_period) != 2
+                || options.skip_period < 1 || options.skip_frames < 0 || options.skip_frames > options.skip_period) {
+                fprintf(stderr, "Invalid frame skip '%s'. Expected SKIP/PERIOD with 0 <= SKIP <= PERIOD.\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-v") == 0) {
+            verbosity = 1;
+        }
+        else if (strcmp(argv[i], "-vv") == 0) {
+            verbosity = 2;
+        }
+        else if (argv[i][0] != '-' && rom_path == NULL) {
+            rom_path = argv[i];
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (rom_path == NULL) {
+        print_usage();
+        return 1;
+    }
+
+    ROM *rom = get_rom(rom_path);
+    if (rom == NULL) {
+        return 1;
+    }
+
+    NES *nes = nes_new(rom);
+    if (nes == NULL) {
+        return 1;
+    }
+    nes->bus->diagnostics.verbosity = verbosity;
+    nes_reset(nes);
+
+    HeadlessResult result = run_headless(nes, &options);
+
+    printf("Frames: %i\n", result.frames);
+    if (result.stopped) {
+        printf("Program stopped at %04X\n", nes->cpu->program_counter);
+    }
+    if (result.condition_met) {
+        printf("Condition met\n");
+    }
+    if (result.seconds > 0) {
+        printf("Speed: %.1f frames/s\n", result.frames / result.seconds);
+    }
+    printf("Frame hash: %016llX\n", (unsigned long long) hash_frame(nes->frame));
+    printf("RAM hash: %016llX\n", (unsigned long long) hash_ram(nes));
+    if (verbosity > 0) {
+        diagnostics_report(&nes->bus->diagnostics, stderr);
+    }
+
+    nes_destroy(nes);
+    return 0;
+}
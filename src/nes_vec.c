@@ -0,0 +1,187 @@
+#include "../lib/nes_vec.h"
+#include "../lib/nes.h"
+#include "../lib/bus.h"
+#include "../lib/ppu.h"
+#include "../lib/joypad.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct NESVecThread {
+    NESVec *envs;
+    int index;
+} NESVecThread;
+
+int nes_vec_observation_size(Observation observation) {
+    switch (observation) {
+        case ObserveRam:
+            return sizeof(((Bus *) NULL)->ram);
+        case ObserveFrame:
+            return sizeof(((NES *) NULL)->frame);
+        default:
+            return 0;
+    }
+}
+
+// Steps the consoles of chunk 'index' that are among the first 'step_count'
+static void step_chunk(NESVec *envs, int index) {
+    int chunk = (envs->count + envs->thread_count - 1) / envs->thread_count;
+    int first = index * chunk;
+    int last = first + chunk;
+    if (last > envs->step_count) {
+        last = envs->step_count;
+    }
+    int size = nes_vec_observation_size(envs->observation);
+
+    for (int i = first; i < last; i++) {
+        NES *nes = envs->envs[i];
+        if (!envs->done[i]) {
+            joypad_set_buttons(&nes->bus->joypad_1, envs->actions != NULL ? envs->actions[i] : 0);
+            if (!nes_run_frame(nes)) {
+                envs->done[i] = true;
+            }
+        }
+        // Stopped consoles are observed too, their RAM stays as the program left it
+        if (envs->observation == ObserveRam) {
+            memcpy(envs->observations + i * size, nes->bus->ram, size);
+        }
+    }
+}
+
+static void *nes_vec_thread(void *arg) {
+    NESVecThread *thread = arg;
+    NESVec *envs = thread->envs;
+    int generation = 0;
+
+    while (1) {
+        pthread_mutex_lock(&envs->lock);
+        while (envs->generation == generation && !envs->exiting) {
+            pthread_cond_wait(&envs->start, &envs->lock);
+        }
+        if (envs->exiting) {
+            pthread_mutex_unlock(&envs->lock);
+            break;
+        }
+        generation = envs->generation;
+        pthread_mutex_unlock(&envs->lock);
+
+        step_chunk(envs, thread->index);
+
+        pthread_mutex_lock(&envs->lock);
+        if (--envs->pending == 0) {
+            pthread_cond_signal(&envs->finish);
+        }
+        pthread_mutex_unlock(&envs->lock);
+    }
+
+    free(thread);
+    return NULL;
+}
+
+// Wraps 'count' consoles, which stay owned by the caller
+// 'observations' must hold 'count' times 'nes_vec_observation_size(observation)' bytes
+// With ObserveFrame the consoles draw into it directly until the vector is destroyed
+NESVec *nes_vec_new(NES **envs, int count, int thread_count, Observation observation, uint8_t *observations) {
+    NESVec *vec = malloc(sizeof(NESVec));
+    vec->envs = envs;
+    vec->count = count;
+    vec->observation = observation;
+    vec->observations = observations;
+    vec->done = calloc(count > 0 ? count : 1, sizeof(bool));
+
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+    if (thread_count > count && count > 0) {
+        thread_count = count;
+    }
+    vec->thread_count = thread_count;
+    vec->threads = malloc(sizeof(pthread_t) * thread_count);
+    pthread_mutex_init(&vec->lock, NULL);
+    pthread_cond_init(&vec->start, NULL);
+    pthread_cond_init(&vec->finish, NULL);
+    vec->generation = 0;
+    vec->pending = 0;
+    vec->exiting = false;
+    vec->actions = NULL;
+    vec->step_count = 0;
+
+    if (observation == ObserveFrame) {
+        int size = nes_vec_observation_size(observation);
+        for (int i = 0; i < count; i++) {
+            envs[i]->ppu->frame = observations + i * size;
+        }
+    }
+
+    // Thread 0 is the caller
+    for (int i = 1; i < thread_count; i++) {
+        NESVecThread *thread = malloc(sizeof(NESVecThread));
+        thread->envs = vec;
+        thread->index = i;
+        if (pthread_create(&vec->threads[i], NULL, nes_vec_thread, thread) != 0) {
+            // Runs with the threads that could be started
+            free(thread);
+            vec->thread_count = i;
+            break;
+        }
+    }
+    return vec;
+}
+
+void nes_vec_destroy(NESVec *envs) {
+    pthread_mutex_lock(&envs->lock);
+    envs->exiting = true;
+    pthread_cond_broadcast(&envs->start);
+    pthread_mutex_unlock(&envs->lock);
+    for (int i = 1; i < envs->thread_count; i++) {
+        pthread_join(envs->threads[i], NULL);
+    }
+
+    // Gives the consoles their own framebuffers back
+    for (int i = 0; i < envs->count; i++) {
+        envs->envs[i]->ppu->frame = envs->envs[i]->frame;
+    }
+
+    pthread_cond_destroy(&envs->start);
+    pthread_cond_destroy(&envs->finish);
+    pthread_mutex_destroy(&envs->lock);
+    free(envs->threads);
+    free(envs->done);
+    free(envs);
+}
+
+// Runs the first 'n' consoles for one frame each, console i pressing the buttons in 'actions[i]'
+// 'actions' uses the joypad button bits and may be NULL for no input
+// Nothing is allocated, the observations of all 'n' consoles are written before returning, stopped ones included
+void nes_vec_step(NESVec *envs, const uint8_t *actions, int n) {
+    if (n > envs->count) {
+        n = envs->count;
+    }
+
+    pthread_mutex_lock(&envs->lock);
+    envs->actions = actions;
+    envs->step_count = n;
+    envs->pending = envs->thread_count - 1;
+    envs->generation++;
+    pthread_cond_broadcast(&envs->start);
+    pthread_mutex_unlock(&envs->lock);
+
+    step_chunk(envs, 0);
+
+    pthread_mutex_lock(&envs->lock);
+    while (envs->pending > 0) {
+        pthread_cond_wait(&envs->finish, &envs->lock);
+    }
+    pthread_mutex_unlock(&envs->lock);
+}
+
+// Powers console 'index' back on with its current cartridge
+void nes_vec_reset(NESVec *envs, int index) {
+    NES *nes = envs->envs[index];
+    nes_load(nes, nes->rom);
+    nes_reset(nes);
+    envs->done[index] = false;
+}
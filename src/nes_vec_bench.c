@@ -0,0 +1,125 @@
+#include "../lib/nes_vec.h"
+#include "../lib/nes.h"
+#include "../lib/cartridge.h"
+#include "../lib/batch.h"
+#include "../lib/headless.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Measures how many console frames per second 'nes_vec_step()' runs
+// Usage: nes_vec_bench [-n ENVS] [-j THREADS] [-s STEPS] [-o none | ram | frame] <file.nes>
+//   -n ENVS      Consoles stepped in lockstep (default: 16)
+//   -j THREADS   Threads splitting the consoles (default: one per core)
+//   -s STEPS     Frames every console runs (default: 600)
+//   -o TYPE      Observation written after every step (default: ram)
+
+void print_usage(void) {
+    fprintf(stderr, "Usage: nes_vec_bench [-n ENVS] [-j THREADS] [-s STEPS] [-o none | ram | frame] <file.nes>\n");
+}
+
+int main(int argc, char **argv) {
+    int count = 16;
+    int thread_count = 0;
+    int steps = 600;
+    Observation observation = ObserveRam;
+    char *rom_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            steps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "none") == 0) {
+                observation = ObserveNone;
+            }
+            else if (strcmp(argv[i], "ram") == 0) {
+                observation = ObserveRam;
+            }
+            else if (strcmp(argv[i], "frame") == 0) {
+                observation = ObserveFrame;
+            }
+            else {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (argv[i][0] != '-' && rom_path == NULL) {
+            rom_path = argv[i];
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (rom_path == NULL || count < 1) {
+        print_usage();
+        return 1;
+    }
+    if (thread_count < 1) {
+        thread_count = batch_default_workers();
+    }
+
+    // Every console runs off the same mapping of the ROM
+    ROM *rom = get_rom(rom_path);
+    if (rom == NULL) {
+        return 1;
+    }
+    NES **envs = malloc(sizeof(NES *) * count);
+    for (int i = 0; i < count; i++) {
+        envs[i] = nes_new(rom_retain(rom));
+        if (envs[i] == NULL) {
+            while (i-- > 0) {
+                nes_destroy(envs[i]);
+            }
+            free(envs);
+            free_rom(rom);
+            return 1;
+        }
+        nes_reset(envs[i]);
+    }
+    free_rom(rom);
+
+    int size = nes_vec_observation_size(observation);
+    uint8_t *observations = malloc(size * count > 0 ? size * count : 1);
+    uint8_t *actions = malloc(count);
+    NESVec *vec = nes_vec_new(envs, count, thread_count, observation, observations);
+
+    // Fixed pseudo-random input so runs can be compared
+    uint32_t seed = 1;
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int step = 0; step < steps; step++) {
+        for (int i = 0; i < count; i++) {
+            seed = seed * 1103515245 + 12345;
+            actions[i] = seed >> 24;
+        }
+        nes_vec_step(vec, actions, count);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("Consoles: %i, threads: %i, steps: %i\n", count, vec->thread_count, steps);
+    printf("Speed: %.1f env-steps/s\n", seconds > 0 ? (double) count * steps / seconds : 0.0);
+    printf("Observation hash: %016llX\n", (unsigned long long) hash_bytes(observations, size * count));
+
+    nes_vec_destroy(vec);
+    for (int i = 0; i < count; i++) {
+        nes_destroy(envs[i]);
+    }
+    free(envs);
+    free(observations);
+    free(actions);
+    return 0;
+}
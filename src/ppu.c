@@ -1,6 +1,6 @@
 #include "../lib/ppu.h"
 #include "../lib/bus.h"
-#include "../lib/io.h"
+#include "../lib/renderer.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -8,58 +8,309 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+// VRAM page behind each nametable, for every type of mirroring
+static const uint8_t MIRRORING_PAGES[][4] = {
+    [Vertical] = {0, 1, 0, 1},
+    [Horizontal] = {0, 0, 1, 1},
+    [FourScreen] = {0, 1, 2, 3},
+    [SingleScreenLower] = {0, 0, 0, 0},
+    [SingleScreenUpper] = {1, 1, 1, 1},
+};
+
 // Instantiates a new PPU
-PPU *ppu_new(uint8_t *chr_rom, Mirroring mirroring) {
+PPU *ppu_new(ROM *rom) {
     PPU *ppu = malloc(sizeof(PPU));
+    ppu_create(ppu, rom);
+    return ppu;
+}
+
+// Builds a PPU in memory owned by the caller
+void ppu_create(PPU *ppu, ROM *rom) {
+    ppu->frame = NULL;
+    ppu->skip_frames = 0;
+    ppu->skip_period = 1;
+    ppu_init(ppu, rom);
+}
+
+// Puts the PPU back in its power-up state for 'rom'
+// Keeps the framebuffer it draws into and the frame skip setting
+void ppu_init(PPU *ppu, ROM *rom) {
     // Initialize registers
     ppu->controller = 0;
     ppu->mask = 0;
     ppu->status = 0;
     ppu->oam_addr = 0;
     ppu->oam_data_reg = 0;
-    ppu->scroll = 0;
-    ppu->addr = addrregister_new();
     ppu->data = 0;
     ppu->oam_dma = 0;
-
-    ppu->chr_rom = chr_rom;
-    ppu->mirroring = mirroring;
-    ppu->cycle = 0;
-    ppu->scanline = 0;
-
+    ppu->v = 0;
+    ppu->t = 0;
+    ppu->fine_x = 0;
+    ppu->write_toggle = false;
+    ppu->data_target = NULL;
+    ppu->data_window = DATA_WINDOW_NONE;
+    ppu->data_stride = 1;
+    ppu->internal_data_buffer = 0;
+
+    // Pattern memory is mapped in by mapper_init()
+    for (int i = 0; i < CHR_BANKS; i++) {
+        ppu->chr_banks[i] = NULL;
+    }
+    // Carts without CHR ROM have CHR RAM instead
+    ppu->chr_ram = rom->chr_rom_length == 0;
+    ppu->dot = 0;
+    ppu->next_event = VBLANK_DOT;
+    ppu->next_sync = VBLANK_DOT;
+    ppu->sprite_zero_hit_dot = -1;
+    ppu->drawn_scanlines = 0;
+    ppu->frame_complete = false;
+    ppu->frame_number = 0;
+
+    ppu->mapper = NULL;
+    ppu->a12_scanlines = 0;
     ppu->interrupt = None;
     
     memset(ppu->vram, 0, sizeof(ppu->vram)/sizeof(ppu->vram[0]));
-    memset(ppu->vram, 0, sizeof(ppu->oam_data)/sizeof(ppu->oam_data[0]));
-    memset(ppu->vram, 0, sizeof(ppu->palette_table)/sizeof(ppu->palette_table[0]));
+    memset(ppu->oam_data, 0, sizeof(ppu->oam_data)/sizeof(ppu->oam_data[0]));
+    memset(ppu->palette_table, 0, sizeof(ppu->palette_table)/sizeof(ppu->palette_table[0]));
 
-    return ppu;
+    ppu_set_mirroring(ppu, rom->mirroring);
+
+    ppu->overflow_scanline = -1;
+    ppu->sprites_dirty = true;
+    tile_cache_init(&ppu->tile_cache);
 }
 
 // Returns interrupt to be performed
+// Only counts dots until the next event or cartridge IRQ is due, see ppu_sync()
 Interrupt ppu_tick(PPU *ppu, int cycles) {
-    Color color = {0, 0, 0};
-    Interrupt interrupt = None;
-    for (int i = 0; i < cycles; i++) {
-        color.r = ppu->cycle % 255;
-        color.b = ppu->scanline % 255;
-        color.g--;
-
-        ppu->cycle++;
-        
-        if (ppu->cycle >=0 && ppu->cycle <= FRAME_WIDTH && ppu->scanline >= 0 && ppu->scanline <= FRAME_HEIGHT) {
-            draw_pixel(frame, ppu->cycle, ppu->scanline, color);
+    ppu->dot += cycles;
+    if (ppu->dot >= ppu->next_sync) {
+        ppu_sync(ppu);
+    }
+    return ppu->interrupt;
+}
+
+// Returns 'v' moved down one pixel row, wrapping into the nametable below after the last row of tiles
+static uint16_t ppu_increment_y(uint16_t v) {
+    if ((v & SCROLL_FINE_Y) != SCROLL_FINE_Y) {
+        return v + 0x1000;
+    }
+    v &= ~SCROLL_FINE_Y;
+    int coarse_y = (v & SCROLL_COARSE_Y) >> 5;
+    if (coarse_y == NAMETABLE_ROWS - 1) {
+        coarse_y = 0;
+        v ^= SCROLL_NAMETABLE_Y;
+    }
+    else if (coarse_y == 31) {
+        // Rows 30 and 31 hold attributes, scrolling into them wraps without switching nametables
+        coarse_y = 0;
+    }
+    else {
+        coarse_y++;
+    }
+    return (v & ~SCROLL_COARSE_Y) | (coarse_y << 5);
+}
+
+// Returns the scroll position 'v' moves on to after a rendered scanline
+// Dot 256 moves it down a pixel row and dot 257 copies the horizontal bits back from 't'
+static uint16_t ppu_next_scanline(PPU *ppu, uint16_t v) {
+    v = ppu_increment_y(v);
+    return (v & ~SCROLL_HORIZONTAL) | (ppu->t & SCROLL_HORIZONTAL);
+}
+
+// Works out the dot at which sprite 0 next hits the background, looking at the pixels that come out after 'dot'
+// The ones before it were already checked. Scanlines further down are drawn with the registers as they are now,
+// so the prediction holds until the next write, see ppu_reschedule()
+static void ppu_predict_sprite_zero_hit(PPU *ppu, int dot) {
+    ppu->sprite_zero_hit_dot = -1;
+    uint16_t v = ppu->v;
+    for (int scanline = ppu->drawn_scanlines; scanline < MAX_VISIBLE_SCANLINES; scanline++) {
+        // Pixel x comes out on dot x + 1
+        int line_start = scanline * SCANLINE_CYCLES;
+        int x = sprite_zero_hit_x(ppu, scanline, v, dot > line_start ? dot - line_start : 0);
+        if (x >= 0) {
+            ppu->sprite_zero_hit_dot = line_start + x + 1;
+            return;
         }
-        if (ppu->cycle == 341) {
-            ppu->scanline++;
-            ppu->cycle = 0;
+        if (x == SPRITE_ZERO_NEVER_HITS) {
+            return;
         }
-        if (ppu->scanline == MAX_SCANLINES) {
-            ppu->scanline = 0;
-            interrupt = NMI;
+        v = ppu_next_scanline(ppu, v);
+    }
+}
+
+// Sets SPRITE_ZERO_HIT once the PPU gets to the dot of the predicted hit
+static void ppu_check_sprite_zero_hit(PPU *ppu, int dot) {
+    if (ppu->sprite_zero_hit_dot >= 0 && dot >= ppu->sprite_zero_hit_dot) {
+        ppu_status_bit_set(ppu, SPRITE_ZERO_HIT);
+        ppu->sprite_zero_hit_dot = -1;
+    }
+}
+
+// Handles the event at 'next_event' and schedules the one after it
+static void ppu_handle_event(PPU *ppu) {
+    switch (ppu->next_event) {
+        case VBLANK_DOT:
+            ppu_status_bit_set(ppu, VBLANK_STARTED);
+            if (ppu_controller_bit_is_set(ppu, GENERATE_NMI)) {
+                ppu->interrupt = NMI;
+            }
+            ppu->frame_complete = true;
+            ppu->next_event = PRE_RENDER_DOT;
+            break;
+        case PRE_RENDER_DOT:
+            ppu_status_bit_unset(ppu, VBLANK_STARTED | SPRITE_ZERO_HIT | SPRITE_OVERFLOW);
+            ppu->next_event = SCROLL_RELOAD_DOT;
+            break;
+        case SCROLL_RELOAD_DOT:
+            // The horizontal bits were copied at dot 257 and the vertical ones over dots 280-304
+            if (ppu->mask & (SHOW_BACKGROUND | SHOW_SPRITES)) {
+                ppu->v = ppu->t;
+            }
+            ppu->next_event = FRAME_DOTS;
+            break;
+        default:
+            ppu->dot -= FRAME_DOTS;
+            ppu->drawn_scanlines = 0;
+            ppu->a12_scanlines = 0;
+            ppu->frame_number++;
+            ppu->next_event = VBLANK_DOT;
+            ppu_predict_sprite_zero_hit(ppu, 0);
+            break;
+    }
+}
+
+// Returns the dot of each rendered scanline at which PPU address line A12 rises, or -1 if it doesn't
+// Pattern fetches for the background run over dots 1-256 and 321-336, the ones for sprites over dots 257-320.
+// A12 only rises once per scanline when the two use different pattern tables, so the edge follows from the
+// controller alone. 8x16 sprites fetch unused slots from tile $FF, which is in the $1000 table
+static int ppu_a12_rise_dot(PPU *ppu) {
+    if (!(ppu->mask & (SHOW_BACKGROUND | SHOW_SPRITES))) {
+        return -1;
+    }
+    bool background_high = ppu->controller & BACKGROUND_PATTERN_ADDR;
+    bool sprites_high = ppu->controller & (SPRITE_SIZE | SPRITE_PATTERN_ADDR);
+    if (sprites_high && !background_high) {
+        return A12_SPRITE_FETCH_DOT;
+    }
+    if (background_high && !sprites_high) {
+        return A12_BACKGROUND_FETCH_DOT;
+    }
+    return -1;
+}
+
+// Visible scanlines and the pre-render scanline fetch patterns
+static bool ppu_scanline_fetches(int scanline) {
+    return scanline < MAX_VISIBLE_SCANLINES || scanline == PRE_RENDER_SCANLINE;
+}
+
+// Clocks the mapper for every A12 edge up to 'dot'
+static void ppu_clock_a12(PPU *ppu, int dot) {
+    int rise = ppu_a12_rise_dot(ppu);
+    // Scanlines without an edge are still passed at the usual dot
+    int line_dot = rise < 0 ? A12_SPRITE_FETCH_DOT : rise;
+    for (; ppu->a12_scanlines < MAX_SCANLINES; ppu->a12_scanlines++) {
+        if (ppu->a12_scanlines * SCANLINE_CYCLES + line_dot > dot) {
+            break;
+        }
+        if (rise >= 0 && ppu_scanline_fetches(ppu->a12_scanlines)) {
+            ppu->mapper->a12_clock(ppu->mapper);
+        }
+    }
+}
+
+// Moves 'next_sync' up to the predicted sprite 0 hit or the A12 edge that makes the mapper raise its IRQ,
+// whichever comes first if it is before the next event
+static void ppu_schedule_sync(PPU *ppu) {
+    ppu->next_sync = ppu->next_event;
+    if (ppu->sprite_zero_hit_dot >= 0 && ppu->sprite_zero_hit_dot < ppu->next_sync) {
+        ppu->next_sync = ppu->sprite_zero_hit_dot;
+    }
+    if (ppu->mapper == NULL) {
+        return;
+    }
+    int clocks = ppu->mapper->a12_clocks_until_irq(ppu->mapper);
+    int rise = ppu_a12_rise_dot(ppu);
+    if (clocks <= 0 || rise < 0) {
+        return;
+    }
+    // Later frames are scheduled when this one wraps around
+    for (int scanline = ppu->a12_scanlines; scanline < MAX_SCANLINES; scanline++) {
+        if (ppu_scanline_fetches(scanline) && --clocks == 0) {
+            int dot = scanline * SCANLINE_CYCLES + rise;
+            if (dot < ppu->next_sync) {
+                ppu->next_sync = dot;
+            }
+            return;
         }
     }
-    return interrupt;
+}
+
+// Works out again when the next sprite 0 hit and mapper IRQ are due, from the dot the PPU is at
+// Register, PPU memory, OAM and bank writes all change when those are, so this is called after each of them
+void ppu_reschedule(PPU *ppu) {
+    ppu_predict_sprite_zero_hit(ppu, ppu->dot);
+    ppu_schedule_sync(ppu);
+}
+
+// Catches the PPU up with the dots counted by ppu_tick()
+// Visible scanlines are drawn whole once the PPU gets to dot 257, where their last pixel is out and the
+// horizontal scroll is reloaded. Drawing them late doesn't show, since every register access syncs first.
+// Sprite 0 hits are the exception, the CPU can poll for them mid-scanline. They are predicted ahead and
+// the PPU syncs on the dot of the hit, so $2002 has the flag from that dot on.
+// SPRITE_OVERFLOW is only set at dot 257, up to 190 dots after the hardware finds the 9th sprite
+void ppu_sync(PPU *ppu) {
+    while (1) {
+        bool draw = ppu->frame != NULL && ppu_frame_drawn(ppu);
+        int dot = ppu->dot < ppu->next_event ? ppu->dot : ppu->next_event;
+        int completed = (dot + SCANLINE_CYCLES - SCANLINE_END_DOT) / SCANLINE_CYCLES;
+        if (completed > MAX_VISIBLE_SCANLINES) {
+            completed = MAX_VISIBLE_SCANLINES;
+        }
+        while (ppu->drawn_scanlines < completed) {
+            // Sprite flags are visible to the game, so they are kept up to date even when nothing is drawn
+            render_sprite_overflow(ppu, ppu->drawn_scanlines);
+            if (draw) {
+                render_scanline(ppu, ppu->drawn_scanlines);
+            }
+            if (ppu->mask & (SHOW_BACKGROUND | SHOW_SPRITES)) {
+                ppu->v = ppu_next_scanline(ppu, ppu->v);
+            }
+            ppu->drawn_scanlines++;
+        }
+        ppu_check_sprite_zero_hit(ppu, dot);
+        if (ppu->mapper != NULL) {
+            ppu_clock_a12(ppu, dot);
+        }
+        if (ppu->dot < ppu->next_event) {
+            ppu_schedule_sync(ppu);
+            return;
+        }
+        ppu_handle_event(ppu);
+    }
+}
+
+// Skips drawing 'skip_frames' out of every 'skip_period' frames
+// Meant to be changed between frames, a frame skipped halfway through is left half drawn
+void ppu_set_frame_skip(PPU *ppu, int skip_frames, int skip_period) {
+    if (skip_period < 1) {
+        skip_period = 1;
+    }
+    if (skip_frames < 0) {
+        skip_frames = 0;
+    }
+    else if (skip_frames > skip_period) {
+        skip_frames = skip_period;
+    }
+    ppu->skip_frames = skip_frames;
+    ppu->skip_period = skip_period;
+}
+
+// Returns true if the current frame is drawn
+// Skipped frames leave the framebuffer holding the last frame that was drawn
+bool ppu_frame_drawn(PPU *ppu) {
+    return ppu->frame_number % ppu->skip_period >= ppu->skip_frames;
 }
 
 // Checks if the specified flag in the controller register is set
@@ -92,44 +343,124 @@ bool ppu_statuts_bit_is_set(PPU *ppu, uint8_t flag) {
 
 // VRAM functions
 
-// Increments the address register 
+// Moves 'v' to the next address after an access through 0x2007
 void ppu_vram_addr_increment(PPU *ppu) {
+    ppu->v = (ppu->v + ppu->data_stride) & 0x7FFF;
 }
 
-// Returns address to be accessed in the VRAM based on type of mirroring
-uint16_t ppu_mirror_vram_addr(PPU *ppu, uint16_t addr) {
-    uint16_t mirrored_vram = addr & 0x2EFF;
-    // Converts to index usable in the VRAM array
-    uint16_t vram_index = mirrored_vram - 0x2000;
-    uint16_t name_table = vram_index / 0x400;
+// Points each nametable at its 1 kB of VRAM
+// Called with the cartridge's mirroring on power-up, mappers that control it call it again when it changes
+void ppu_set_mirroring(PPU *ppu, Mirroring mirroring) {
+    for (int i = 0; i < 4; i++) {
+        ppu->nametables[i] = ppu->vram + MIRRORING_PAGES[mirroring][i] * NAMETABLE_SIZE;
+    }
+    ppu->mirroring = mirroring;
+    ppu->data_window = DATA_WINDOW_NONE;
+}
 
-    switch (ppu->mirroring) {
-        case Vertical:
-            return vram_index - 0x800;
-        case Horizontal:
-            if (name_table == 1 || name_table == 2) {
-                return vram_index - 0x400;
-            }
-            else if (name_table == 3) {
-                return vram_index - 0x800;
-            }
-        default:
-            return vram_index;
+// Points 'count' CHR banks from 'bank' at consecutive 1 kB blocks of 'memory'
+// Switching banks only swaps pointers, tiles are decoded again when next drawn
+void ppu_map_chr(PPU *ppu, int bank, uint8_t *memory, int count) {
+    for (int i = 0; i < count; i++) {
+        uint8_t *block = memory + i * CHR_BANK_SIZE;
+        if (ppu->chr_banks[bank + i] != block) {
+            ppu->chr_banks[bank + i] = block;
+            tile_cache_invalidate(&ppu->tile_cache, (bank + i) * CHR_BANK_SIZE, CHR_BANK_SIZE);
+        }
     }
+    ppu->data_window = DATA_WINDOW_NONE;
 }
 
 // Memory functions
 
-// Read memory from PPU memory
+// Returns the index in 'palette_table' for a palette address
+// The backdrop entries of the sprite palettes mirror the background ones
+static uint8_t ppu_palette_index(uint16_t addr) {
+    uint8_t index = addr & 0x1F;
+    if ((index & 0x13) == 0x10) {
+        index &= ~0x10;
+    }
+    return index;
+}
+
+// Reads a byte from pattern memory or the nametables
+static uint8_t ppu_peek(PPU *ppu, uint16_t addr) {
+    if (addr < NAMETABLE_START) {
+        return ppu->chr_banks[addr / CHR_BANK_SIZE][addr % CHR_BANK_SIZE];
+    }
+    return *ppu_nametable_byte(ppu, addr);
+}
+
+// Read memory from PPU memory at 'v'
+// Reads go through a buffer and return the byte from the previous read, except for the palette
 uint8_t ppu_mem_read(PPU *ppu) {
-    return 0;
+    uint16_t addr = ppu->v & 0x3FFF;
+    if (addr >= PALETTE_START) {
+        // The buffer gets the nametable byte underneath the palette
+        ppu->internal_data_buffer = ppu_peek(ppu, addr - 0x1000);
+        return ppu->palette_table[ppu_palette_index(addr)];
+    }
+    uint8_t data = ppu->internal_data_buffer;
+    ppu->internal_data_buffer = ppu_peek(ppu, addr);
+    return data;
+}
+
+// Write to PPU memory at 'v'
+// Writes to CHR ROM are ignored
+void ppu_mem_write(PPU *ppu, uint8_t value) {
+    uint16_t addr = ppu->v & 0x3FFF;
+    if (addr < NAMETABLE_START) {
+        if (ppu->chr_ram) {
+            ppu->chr_banks[addr / CHR_BANK_SIZE][addr % CHR_BANK_SIZE] = value;
+            tile_cache_invalidate(&ppu->tile_cache, addr, 1);
+        }
+    }
+    else if (addr < PALETTE_START) {
+        *ppu_nametable_byte(ppu, addr) = value;
+    }
+    else {
+        ppu->palette_table[ppu_palette_index(addr)] = value;
+    }
+}
+
+// Returns the memory behind a 1 kB window of PPU address space, for the 0x2007 write fast path
+// Returns NULL for CHR ROM, which ignores writes, and for the palette, which has mirrors of its own
+static uint8_t *ppu_resolve_data_window(PPU *ppu, uint16_t window) {
+    if (window < NAMETABLE_START) {
+        return ppu->chr_ram ? ppu->chr_banks[window / CHR_BANK_SIZE] : NULL;
+    }
+    if (window >= (PALETTE_START & ~(DATA_WINDOW_SIZE - 1))) {
+        return NULL;
+    }
+    return ppu_nametable_byte(ppu, window);
+}
+
+// Reads the status register
+// Reading clears VBLANK_STARTED and resets the write toggle shared by 0x2005 and 0x2006
+uint8_t ppu_read_status(PPU *ppu) {
+    // Only the 3 most significant bits are driven, the other 5 come from the buffer
+    uint8_t data = (ppu->status & 0xE0) | (ppu->internal_data_buffer & 0x1F);
+    ppu_status_bit_unset(ppu, VBLANK_STARTED);
+    ppu->write_toggle = false;
+    return data;
 }
 
 // Write to register functions
 
 // Writes value to PPU controller register
 void ppu_write_to_controller(PPU *ppu, uint8_t value) {
+    // Enabling NMI during vblank triggers one straight away
+    if (!(ppu->controller & GENERATE_NMI) && (value & GENERATE_NMI) && (ppu->status & VBLANK_STARTED)) {
+        ppu->interrupt = NMI;
+    }
+    // Sprites have to be evaluated again when their height changes
+    if ((ppu->controller ^ value) & SPRITE_SIZE) {
+        ppu->sprites_dirty = true;
+    }
     ppu->controller = value;
+    ppu->data_stride = value & VRAM_ADDR_INCREMENT ? 32 : 1;
+    // The base nametable is part of the scroll position
+    ppu->t = (ppu->t & ~(SCROLL_NAMETABLE_X | SCROLL_NAMETABLE_Y)) | ((value & (NAMETABLE_ADDR_1 | NAMETABLE_ADDR_2)) << 10);
 }
 // Writes value to PPU mask register
 void ppu_write_to_mask(PPU *ppu, uint8_t value) {
@@ -142,79 +473,71 @@ void ppu_write_to_oam_addr(PPU *ppu, uint8_t value) {
 }
 
 // Writes value to PPU OAM data register
+// Writes go to 'oam_addr', which moves on to the next byte
 void ppu_write_to_oam_data(PPU *ppu, uint8_t value) {
     ppu->oam_data_reg = value;
+    ppu->oam_data[ppu->oam_addr++] = value;
+    ppu->sprites_dirty = true;
 }
 
 // Writes value to PPU scroll register
+// Writes alternate between the X and the Y scroll
 void ppu_write_to_scroll(PPU *ppu, uint8_t value) {
-    ppu->scroll = value;
+    if (ppu->write_toggle) {
+        ppu->t = (ppu->t & ~(SCROLL_FINE_Y | SCROLL_COARSE_Y)) | ((value & 0x07) << 12) | ((value & 0xF8) << 2);
+    }
+    else {
+        ppu->t = (ppu->t & ~SCROLL_COARSE_X) | (value >> 3);
+        ppu->fine_x = value & 0x07;
+    }
+    ppu->write_toggle = !ppu->write_toggle;
 }
 
 // Writes value to PPU address register
+// The high byte comes first, 'v' only changes once both are written
 void ppu_write_to_ppu_addr(PPU *ppu, uint8_t value) {
+    if (ppu->write_toggle) {
+        ppu->t = (ppu->t & 0xFF00) | value;
+        ppu->v = ppu->t;
+    }
+    else {
+        // Bit 14 is cleared as well
+        ppu->t = (ppu->t & 0x00FF) | ((value & 0x3F) << 8);
+    }
+    ppu->write_toggle = !ppu->write_toggle;
 }
 
 // Writes value to PPU data register
+// Bulk uploads are plain stores, the target is only resolved again when 'v' enters another window
 void ppu_write_to_ppu_data(PPU *ppu, uint8_t value) {
     ppu->data = value;
-}
-
-// Writes value to PPU OAM DMA register
-void ppu_write_to_oam_dma(PPU *ppu, uint8_t value) {
-    ppu->oam_dma = value;
-}
-
-// AddrRegister functions
-
-// Instantiates new AddrRegister
-AddrRegister addrregister_new(void) {
-    AddrRegister addr_reg;
-    addr_reg.value[0] = 0;
-    addr_reg.value[1] = 0;
-    addr_reg.high_pointer = true;
-    return addr_reg;
-}
-
-// Sets the PPU address register to a new value
-// Mirrors down addresses above 0x3FFF
-void addrregister_set(AddrRegister addr_reg, uint16_t value) {
-    value &= 0x3FFF;
-    addr_reg.value[0] = value >> 8;
-    addr_reg.value[1] = value & 0xFF;
-}
-
-// Updates one byte of the PPU's address register
-void addrregister_update(AddrRegister addr_reg, uint8_t value) {
-    if (addr_reg.high_pointer) {
-        addr_reg.value[0] = value;
+    uint16_t addr = ppu->v & 0x3FFF;
+    uint16_t window = addr & ~(DATA_WINDOW_SIZE - 1);
+    if (window != ppu->data_window) {
+        ppu->data_window = window;
+        ppu->data_target = ppu_resolve_data_window(ppu, window);
     }
-    else {
-        addr_reg.value[1] = value;
+    if (ppu->data_target == NULL) {
+        ppu_mem_write(ppu, value);
+        return;
     }
-    // Mirrors down any addresses above 0x3FFF
-    uint16_t new_value = addrregister_get(addr_reg);
-    addrregister_set(addr_reg, new_value & 0x3FFF);
-    addr_reg.high_pointer = !addr_reg.high_pointer;
-}
-
-// Increments the PPU's address register's value by 'value'
-// Handles wrap-around
-void addrregister_increment(AddrRegister addr_reg, uint8_t value) {
-    uint8_t low = addr_reg.value[1];
-    addr_reg.value[1] += value;
-    if (low > addr_reg.value[1]) {
-        addr_reg.value[0]++;
+    ppu->data_target[addr & (DATA_WINDOW_SIZE - 1)] = value;
+    if (addr < NAMETABLE_START) {
+        ppu->tile_cache.dirty[addr / TILE_BYTES] = true;
     }
-    // Mirrors down addresses above 0x3FFF
-    uint16_t new_value = addrregister_get(addr_reg);
-    addrregister_set(addr_reg, new_value);
 }
 
-void addrregister_reset_pointer(AddrRegister addr_reg) {
-    addr_reg.high_pointer = true;
+// Writes value to PPU OAM DMA register
+// 'page' holds the 256 bytes read from CPU page 'value', copied to OAM from 'oam_addr' onwards
+void ppu_write_to_oam_dma(PPU *ppu, uint8_t value, const uint8_t *page) {
+    ppu->oam_dma = value;
+    int first = sizeof(ppu->oam_data) - ppu->oam_addr;
+    memcpy(ppu->oam_data + ppu->oam_addr, page, first);
+    memcpy(ppu->oam_data, page + first, ppu->oam_addr);
+    ppu->sprites_dirty = true;
 }
 
-uint16_t addrregister_get(AddrRegister addr_reg) {
-    return (uint16_t) addr_reg.value[0] << 8 | addr_reg.value[1];
+// Reads the OAM byte at 'oam_addr', reads don't move it
+uint8_t ppu_read_oam_data(PPU *ppu) {
+    return ppu->oam_data[ppu->oam_addr];
 }
@@ -0,0 +1,229 @@
+#include "../lib/renderer.h"
+#include "../lib/ppu.h"
+#include "../lib/io.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Renders one visible scanline into the PPU's framebuffer
+void render_scanline(PPU *ppu, int scanline) {
+    uint8_t line[FRAME_WIDTH];
+    render_background(ppu, ppu->v, line);
+    render_sprites(ppu, scanline, line);
+
+    // Only palette indices are written, they are converted to RGB when the frame is presented
+    uint8_t *pixel = ppu->frame + scanline * FRAME_WIDTH;
+    uint8_t grey_mask = ppu->mask & GREYSCALE ? 0x30 : 0x3F;
+    for (int x = 0; x < FRAME_WIDTH; x++) {
+        // Transparent pixels show the backdrop color
+        uint8_t index = line[x] & 0b11 ? line[x] : 0;
+        pixel[x] = ppu->palette_table[index] & grey_mask;
+    }
+    ppu->frame[FRAME_EMPHASIS_OFFSET + scanline] = ppu->mask >> 5;
+}
+
+// Renders the background of one scanline as 'palette_table' indices
+// The scroll position comes from 'v' as it is at the start of the scanline
+// Scrolling is resolved per tile, so each nametable and attribute byte is only read once
+void render_background(PPU *ppu, uint16_t v, uint8_t *line) {
+    if (!(ppu->mask & SHOW_BACKGROUND)) {
+        memset(line, 0, FRAME_WIDTH);
+        return;
+    }
+
+    int coarse_y = (v & SCROLL_COARSE_Y) >> 5;
+    int fine_y = (v & SCROLL_FINE_Y) >> 12;
+    int pattern_table = ppu->controller & BACKGROUND_PATTERN_ADDR ? PATTERN_TABLE_TILES : 0;
+
+    // 33 tiles cover the scanline when it doesn't start on a tile boundary
+    for (int tile = 0; tile <= NAMETABLE_COLUMNS; tile++) {
+        int coarse_x = v & SCROLL_COARSE_X;
+        const uint8_t *nametable = ppu->nametables[(v >> 10) & 3];
+
+        uint8_t tile_index = nametable[v & (SCROLL_COARSE_Y | SCROLL_COARSE_X)];
+        // Each attribute byte covers 4x4 tiles, 2 bits per 2x2 quadrant
+        uint8_t attribute = nametable[ATTRIBUTE_TABLE_OFFSET + (coarse_y / 4) * 8 + coarse_x / 4];
+        uint8_t palette = (attribute >> (((coarse_y & 2) << 1) | (coarse_x & 2))) & 0b11;
+
+        const uint8_t *pixels = tile_cache_row(&ppu->tile_cache, ppu->chr_banks, pattern_table + tile_index, fine_y, false);
+
+        // Next tile, wrapping into the nametable on the right
+        if (coarse_x == NAMETABLE_COLUMNS - 1) {
+            v = (v & ~SCROLL_COARSE_X) ^ SCROLL_NAMETABLE_X;
+        }
+        else {
+            v++;
+        }
+
+        int start = tile * TILE_SIZE - ppu->fine_x;
+        for (int i = 0; i < TILE_SIZE; i++) {
+            int screen_x = start + i;
+            if (screen_x < 0 || screen_x >= FRAME_WIDTH) {
+                continue;
+            }
+            line[screen_x] = pixels[i] ? palette << 2 | pixels[i] : 0;
+        }
+    }
+
+    if (!(ppu->mask & SHOW_BACKGROUND_LEFT)) {
+        memset(line, 0, TILE_SIZE);
+    }
+}
+
+// Draws the sprites of one scanline over its background
+// The first opaque sprite pixel in OAM order wins, even if that sprite is behind the background
+void render_sprites(PPU *ppu, int scanline, uint8_t *line) {
+    if (!(ppu->mask & SHOW_SPRITES)) {
+        return;
+    }
+    if (ppu->sprites_dirty) {
+        sprite_evaluate(ppu);
+    }
+
+    bool covered[FRAME_WIDTH] = {false};
+    for (int i = 0; i < ppu->scanline_sprite_count[scanline]; i++) {
+        uint8_t *sprite = ppu->oam_data + ppu->scanline_sprites[scanline][i] * SPRITE_BYTES;
+        uint8_t attribute = sprite[SPRITE_ATTRIBUTE];
+        uint8_t palette = 4 + (attribute & SPRITE_PALETTE);
+        const uint8_t *pixels = sprite_row(ppu, sprite, scanline);
+
+        for (int j = 0; j < TILE_SIZE; j++) {
+            int x = sprite[SPRITE_X] + j;
+            if (x >= FRAME_WIDTH) {
+                break;
+            }
+            if (pixels[j] == 0 || covered[x] || (x < TILE_SIZE && !(ppu->mask & SHOW_SPRITES_LEFT))) {
+                continue;
+            }
+            covered[x] = true;
+            if (!(attribute & SPRITE_BEHIND_BACKGROUND) || !(line[x] & 0b11)) {
+                line[x] = palette << 2 | pixels[j];
+            }
+        }
+    }
+}
+
+// Sets SPRITE_OVERFLOW if the scanline is on or past the first one with a 9th sprite
+void render_sprite_overflow(PPU *ppu, int scanline) {
+    if (!(ppu->mask & (SHOW_BACKGROUND | SHOW_SPRITES))) {
+        return;
+    }
+    if (ppu->sprites_dirty) {
+        sprite_evaluate(ppu);
+    }
+    if (ppu->overflow_scanline != -1 && scanline >= ppu->overflow_scanline) {
+        ppu_status_bit_set(ppu, SPRITE_OVERFLOW);
+    }
+}
+
+// Returns the first pixel from 'first_x' on at which sprite 0 hits the background of the scanline starting at 'v'
+// Returns -1 if it doesn't on this scanline, SPRITE_ZERO_NEVER_HITS if it can't on any scanline until a register
+// changes, that is while SPRITE_ZERO_HIT is already set or a layer is hidden
+int sprite_zero_hit_x(PPU *ppu, int scanline, uint16_t v, int first_x) {
+    if (ppu_statuts_bit_is_set(ppu, SPRITE_ZERO_HIT)
+        || (ppu->mask & (SHOW_BACKGROUND | SHOW_SPRITES)) != (SHOW_BACKGROUND | SHOW_SPRITES)) {
+        return SPRITE_ZERO_NEVER_HITS;
+    }
+    if (ppu->sprites_dirty) {
+        sprite_evaluate(ppu);
+    }
+    if (ppu->scanline_sprite_count[scanline] == 0
+        || ppu->scanline_sprites[scanline][0] != 0
+        || ppu->oam_data[SPRITE_X] + TILE_SIZE <= first_x) {
+        return -1;
+    }
+
+    uint8_t background[FRAME_WIDTH];
+    render_background(ppu, v, background);
+    const uint8_t *pixels = sprite_row(ppu, ppu->oam_data, scanline);
+    bool left_clipped = (ppu->mask & (SHOW_BACKGROUND_LEFT | SHOW_SPRITES_LEFT)) != (SHOW_BACKGROUND_LEFT | SHOW_SPRITES_LEFT);
+
+    for (int i = 0; i < TILE_SIZE; i++) {
+        int x = ppu->oam_data[SPRITE_X] + i;
+        // Never hits on the last pixel
+        if (x >= FRAME_WIDTH - 1) {
+            break;
+        }
+        if (x < first_x || (x < TILE_SIZE && left_clipped)) {
+            continue;
+        }
+        if (pixels[i] != 0 && (background[x] & 0b11)) {
+            return x;
+        }
+    }
+    return -1;
+}
+
+// Sprite functions
+
+int sprite_height(PPU *ppu) {
+    return ppu->controller & SPRITE_SIZE ? TILE_SIZE * 2 : TILE_SIZE;
+}
+
+// Returns true if a sprite with this Y byte covers the scanline
+// Sprites show up one scanline below their Y byte
+static inline bool sprite_in_range(uint8_t y, int scanline, int height) {
+    int row = scanline - (y + 1);
+    return row >= 0 && row < height;
+}
+
+// Rebuilds the sprite list of every scanline from OAM
+// Each sprite's Y range is walked once instead of scanning all of OAM for every scanline
+void sprite_evaluate(PPU *ppu) {
+    int height = sprite_height(ppu);
+    memset(ppu->scanline_sprite_count, 0, sizeof(ppu->scanline_sprite_count));
+    ppu->overflow_scanline = -1;
+
+    for (int i = 0; i < OAM_SPRITES; i++) {
+        int top = ppu->oam_data[i * SPRITE_BYTES + SPRITE_Y] + 1;
+        for (int scanline = top; scanline < top + height && scanline < MAX_VISIBLE_SCANLINES; scanline++) {
+            uint8_t *count = &ppu->scanline_sprite_count[scanline];
+            if (*count < MAX_SCANLINE_SPRITES) {
+                ppu->scanline_sprites[scanline][(*count)++] = i;
+            }
+        }
+    }
+
+    // Past the 8th sprite the hardware keeps searching for a 9th one, but it also steps through
+    // the bytes of each entry, so it reads tiles, attributes and X positions as Y positions
+    for (int scanline = 0; scanline < MAX_VISIBLE_SCANLINES && ppu->overflow_scanline == -1; scanline++) {
+        if (ppu->scanline_sprite_count[scanline] < MAX_SCANLINE_SPRITES) {
+            continue;
+        }
+        int byte = 0;
+        for (int i = ppu->scanline_sprites[scanline][MAX_SCANLINE_SPRITES - 1] + 1; i < OAM_SPRITES; i++) {
+            if (sprite_in_range(ppu->oam_data[i * SPRITE_BYTES + byte], scanline, height)) {
+                ppu->overflow_scanline = scanline;
+                break;
+            }
+            byte = (byte + 1) % SPRITE_BYTES;
+        }
+    }
+    ppu->sprites_dirty = false;
+}
+
+// Returns the pixels of the sprite's row that falls on the scanline, in screen order
+const uint8_t *sprite_row(PPU *ppu, const uint8_t *sprite, int scanline) {
+    int height = sprite_height(ppu);
+    uint8_t attribute = sprite[SPRITE_ATTRIBUTE];
+    int row = scanline - (sprite[SPRITE_Y] + 1);
+    if (attribute & SPRITE_FLIP_VERTICAL) {
+        row = height - 1 - row;
+    }
+
+    int tile = sprite[SPRITE_TILE];
+    if (height == TILE_SIZE * 2) {
+        // 8x16 sprites are two consecutive tiles from the table picked by bit 0
+        tile = (tile & 1) * PATTERN_TABLE_TILES + (tile & 0xFE);
+        if (row >= TILE_SIZE) {
+            tile++;
+            row -= TILE_SIZE;
+        }
+    }
+    else {
+        tile += ppu->controller & SPRITE_PATTERN_ADDR ? PATTERN_TABLE_TILES : 0;
+    }
+
+    return tile_cache_row(&ppu->tile_cache, ppu->chr_banks, tile, row, attribute & SPRITE_FLIP_HORIZONTAL);
+}
@@ -0,0 +1,430 @@
+#include "../lib/rom_cache.h"
+#include "../lib/cartridge.h"
+#include "../lib/checksum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define PRG_RAM_UNIT 1024
+
+// A ROM identified by the hashes of its PRG and CHR, whatever file it came from
+typedef struct RomRecord {
+    uint32_t crc32;
+    uint8_t sha1[SHA1_LENGTH];
+    bool has_sha1; // Database records may only give the CRC
+
+    // Header info, corrected by the database if 'known'
+    bool known;
+    uint16_t mapper;
+    Mirroring mirroring;
+    int prg_ram_length; // Volatile and battery-backed together
+    bool battery;
+
+    ROM *rom; // Reference held by the cache and shared with later files, NULL until one is loaded
+} RomRecord;
+
+// What a file hashed to when it had this size and modification time
+typedef struct FileRecord {
+    char *path;
+    long long size;
+    long long mtime_seconds;
+    long mtime_nanoseconds;
+    uint32_t crc32;
+    uint8_t sha1[SHA1_LENGTH];
+    ROM *rom; // Reference held by the cache, NULL if the file wasn't loaded by this process
+} FileRecord;
+
+// Shared by every thread loading ROMs
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static RomRecord *roms = NULL;
+static int rom_count = 0;
+static int rom_capacity = 0;
+static FileRecord *files = NULL;
+static int file_count = 0;
+static int file_capacity = 0;
+
+// Indexed by Mirroring, single-screen mirroring is only ever set by mappers
+static const char MIRRORING_LETTERS[] = "VH4";
+
+// Record lookup, the caller holds 'cache_lock'
+// Adding returns NULL if the records couldn't grow
+
+static RomRecord *find_rom(uint32_t crc32, const uint8_t *sha1) {
+    for (int i = 0; i < rom_count; i++) {
+        if (roms[i].crc32 == crc32 && (!roms[i].has_sha1 || memcmp(roms[i].sha1, sha1, SHA1_LENGTH) == 0)) {
+            return &roms[i];
+        }
+    }
+    return NULL;
+}
+
+static RomRecord *add_rom(uint32_t crc32, const uint8_t *sha1) {
+    if (rom_count == rom_capacity) {
+        int capacity = rom_capacity > 0 ? rom_capacity * 2 : 64;
+        RomRecord *grown = realloc(roms, sizeof(RomRecord) * capacity);
+        if (grown == NULL) {
+            fprintf(stderr, "Couldn't allocate memory for the ROM cache.\n");
+            return NULL;
+        }
+        roms = grown;
+        rom_capacity = capacity;
+    }
+    RomRecord *record = &roms[rom_count++];
+    memset(record, 0, sizeof(RomRecord));
+    record->crc32 = crc32;
+    if (sha1 != NULL) {
+        memcpy(record->sha1, sha1, SHA1_LENGTH);
+        record->has_sha1 = true;
+    }
+    return record;
+}
+
+static FileRecord *find_file(const char *path) {
+    for (int i = 0; i < file_count; i++) {
+        if (strcmp(files[i].path, path) == 0) {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static FileRecord *add_file(const char *path) {
+    if (file_count == file_capacity) {
+        int capacity = file_capacity > 0 ? file_capacity * 2 : 64;
+        FileRecord *grown = realloc(files, sizeof(FileRecord) * capacity);
+        if (grown == NULL) {
+            fprintf(stderr, "Couldn't allocate memory for the ROM cache.\n");
+            return NULL;
+        }
+        files = grown;
+        file_capacity = capacity;
+    }
+    char *path_copy = malloc(strlen(path) + 1);
+    if (path_copy == NULL) {
+        fprintf(stderr, "Couldn't allocate memory for the ROM cache.\n");
+        return NULL;
+    }
+    strcpy(path_copy, path);
+    FileRecord *record = &files[file_count++];
+    memset(record, 0, sizeof(FileRecord));
+    record->path = path_copy;
+    return record;
+}
+
+// ROMs whose header wasn't corrected are only shared if their headers agree
+static bool same_header(const ROM *rom, const ROM *other) {
+    return rom->mapper == other->mapper
+        && rom->submapper == other->submapper
+        && rom->mirroring == other->mirroring
+        && rom->prg_ram_length == other->prg_ram_length
+        && rom->prg_nvram_length == other->prg_nvram_length
+        && rom->chr_ram_length == other->chr_ram_length
+        && rom->chr_nvram_length == other->chr_nvram_length
+        && rom->battery == other->battery
+        && rom->timing == other->timing;
+}
+
+// Nanoseconds of the modification time, where stat() has them
+#if defined(_WIN32)
+#define MTIME_NANOSECONDS(info) 0
+#elif defined(__APPLE__)
+#define MTIME_NANOSECONDS(info) ((info)->st_mtimespec.tv_nsec)
+#else
+#define MTIME_NANOSECONDS(info) ((info)->st_mtim.tv_nsec)
+#endif
+
+// A file counts as unchanged while its size and modification time are
+static bool file_unchanged(const FileRecord *record, const struct stat *info) {
+    return record->size == info->st_size
+        && record->mtime_seconds == info->st_mtime
+        && record->mtime_nanoseconds == MTIME_NANOSECONDS(info);
+}
+
+// Returns the cached ROM of a file loaded before, NULL if it wasn't or it changed since
+// The ROM comes with a reference for the caller
+ROM *rom_cache_find_file(const char *file_path, const struct stat *info) {
+    ROM *rom = NULL;
+    pthread_mutex_lock(&cache_lock);
+    FileRecord *file = find_file(file_path);
+    if (file != NULL && file->rom != NULL && file_unchanged(file, info)) {
+        rom = rom_retain(file->rom);
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return rom;
+}
+
+// Caches 'rom', just mapped from 'file_path', under the hashes of its PRG and CHR
+// If the same content is cached already, 'rom' is released and the cached ROM returned instead
+// Otherwise its header info is corrected from the database, PRG and CHR alone can't tell headers apart
+// unless the database knows them
+// The ROM returned comes with a reference for the caller, 'rom' is returned uncached if the records can't grow
+ROM *rom_cache_add(ROM *rom, const char *file_path, const struct stat *info) {
+    // Hashes are taken over from the file's record when it's unchanged, computed without the lock otherwise
+    uint32_t crc32 = 0;
+    uint8_t sha1[SHA1_LENGTH];
+    pthread_mutex_lock(&cache_lock);
+    FileRecord *file = find_file(file_path);
+    bool hashed = file != NULL && file_unchanged(file, info);
+    if (hashed) {
+        crc32 = file->crc32;
+        memcpy(sha1, file->sha1, SHA1_LENGTH);
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    if (!hashed) {
+        // CHR follows PRG in the file, so both are hashed at once
+        int length = rom->prg_rom_length + rom->chr_rom_length;
+        crc32 = crc32_bytes(rom->prg_rom, length);
+        sha1_bytes(rom->prg_rom, length, sha1);
+    }
+
+    // Records may have been added or moved while the lock was released, so they're looked up again
+    pthread_mutex_lock(&cache_lock);
+    file = find_file(file_path);
+    if (file == NULL) {
+        file = add_file(file_path);
+        if (file == NULL) {
+            pthread_mutex_unlock(&cache_lock);
+            return rom;
+        }
+    }
+    if (!hashed) {
+        file->crc32 = crc32;
+        memcpy(file->sha1, sha1, SHA1_LENGTH);
+        file->size = info->st_size;
+        file->mtime_seconds = info->st_mtime;
+        file->mtime_nanoseconds = MTIME_NANOSECONDS(info);
+    }
+
+    RomRecord *record = find_rom(crc32, sha1);
+    if (record == NULL) {
+        record = add_rom(crc32, sha1);
+        if (record == NULL) {
+            pthread_mutex_unlock(&cache_lock);
+            return rom;
+        }
+        record->mapper = rom->mapper;
+        record->mirroring = rom->mirroring;
+        record->prg_ram_length = rom->prg_ram_length + rom->prg_nvram_length;
+        record->battery = rom->battery;
+    }
+    else if (!record->has_sha1) {
+        memcpy(record->sha1, sha1, SHA1_LENGTH);
+        record->has_sha1 = true;
+    }
+
+    if (record->rom != NULL && (record->known || same_header(record->rom, rom))) {
+        // Another file, or an older copy of this one, has the same content
+        free_rom(rom);
+        rom = rom_retain(record->rom);
+    }
+    else {
+        if (record->known) {
+            rom->mapper = record->mapper;
+            rom->mirroring = record->mirroring;
+            // The battery keeps all of the PRG RAM or none of it
+            rom->prg_ram_length = record->battery ? 0 : record->prg_ram_length;
+            rom->prg_nvram_length = record->battery ? record->prg_ram_length : 0;
+            rom->battery = record->battery;
+            rom->verified = true;
+        }
+        if (record->rom == NULL) {
+            record->rom = rom_retain(rom);
+        }
+    }
+    if (file->rom != rom) {
+        if (file->rom != NULL) {
+            free_rom(file->rom);
+        }
+        file->rom = rom_retain(rom);
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return rom;
+}
+
+// Reads records from the database at 'file_path', a missing file is an empty database
+// Returns false if the file is invalid
+bool rom_cache_load_database(const char *file_path) {
+    FILE *file = fopen(file_path, "r");
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        fprintf(stderr, "Couldn't open ROM database '%s'.\n", file_path);
+        return false;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    bool valid = true;
+    bool allocated = true;
+    char line[ROM_DATABASE_LINE_LENGTH];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char *start = line + strspn(line, " \t");
+        if (*start == '#' || *start == '\0') {
+            continue;
+        }
+
+        uint32_t crc32;
+        char sha1_string[SHA1_STRING_LENGTH];
+        uint8_t sha1[SHA1_LENGTH];
+        bool known = strncmp(start, "rom ", 4) == 0;
+        if (known || strncmp(start, "seen ", 5) == 0) {
+            int mapper;
+            char mirroring;
+            int prg_ram_kb;
+            int battery;
+            if (sscanf(strchr(start, ' '), "%x %40s %i %c %i %i", &crc32, sha1_string, &mapper, &mirroring, &prg_ram_kb, &battery) != 6
+                || (strcmp(sha1_string, "-") != 0 && !sha1_from_string(sha1_string, sha1))
+                || strchr(MIRRORING_LETTERS, mirroring) == NULL) {
+                valid = false;
+                break;
+            }
+            bool has_sha1 = strcmp(sha1_string, "-") != 0;
+            RomRecord *record = NULL;
+            for (int i = 0; i < rom_count && record == NULL; i++) {
+                if (roms[i].crc32 == crc32 && roms[i].has_sha1 == has_sha1 && (!has_sha1 || memcmp(roms[i].sha1, sha1, SHA1_LENGTH) == 0)) {
+                    record = &roms[i];
+                }
+            }
+            if (record == NULL) {
+                record = add_rom(crc32, has_sha1 ? sha1 : NULL);
+                if (record == NULL) {
+                    allocated = false;
+                    break;
+                }
+            }
+            else if (record->known && !known) {
+                continue;
+            }
+            record->known = known;
+            record->mapper = mapper;
+            record->mirroring = strchr(MIRRORING_LETTERS, mirroring) - MIRRORING_LETTERS;
+            record->prg_ram_length = prg_ram_kb * PRG_RAM_UNIT;
+            record->battery = battery != 0;
+        }
+        else if (strncmp(start, "file ", 5) == 0) {
+            long long size;
+            long long mtime_seconds;
+            long mtime_nanoseconds;
+            int path_start = 0;
+            if (sscanf(start, "file %lli %lli %li %x %40s %n", &size, &mtime_seconds, &mtime_nanoseconds, &crc32, sha1_string, &path_start) != 5
+                || path_start == 0 || start[path_start] == '\0' || !sha1_from_string(sha1_string, sha1)) {
+                valid = false;
+                break;
+            }
+            FileRecord *record = find_file(start + path_start);
+            if (record == NULL) {
+                record = add_file(start + path_start);
+                if (record == NULL) {
+                    allocated = false;
+                    break;
+                }
+            }
+            record->size = size;
+            record->mtime_seconds = mtime_seconds;
+            record->mtime_nanoseconds = mtime_nanoseconds;
+            record->crc32 = crc32;
+            memcpy(record->sha1, sha1, SHA1_LENGTH);
+        }
+        else {
+            valid = false;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    fclose(file);
+
+    if (!allocated) {
+        return false;
+    }
+    if (!valid) {
+        fprintf(stderr, "Invalid record at line %i of '%s'.\n", line_number, file_path);
+    }
+    return valid;
+}
+
+// Writes every record to the database at 'file_path'
+// The file is replaced at once, so readers never see half of it
+bool rom_cache_save_database(const char *file_path) {
+    char temporary_path[ROM_DATABASE_LINE_LENGTH];
+    if (snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", file_path) >= (int) sizeof(temporary_path)) {
+        return false;
+    }
+    FILE *file = fopen(temporary_path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Couldn't write ROM database '%s'.\n", file_path);
+        return false;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    fprintf(file, "# rom | seen <crc32> <sha1 | -> <mapper> <H | V | 4> <prg ram kB> <battery>\n");
+    char sha1_string[SHA1_STRING_LENGTH];
+    for (int i = 0; i < rom_count; i++) {
+        RomRecord *record = &roms[i];
+        if (record->mirroring > FourScreen) {
+            continue;
+        }
+        if (record->has_sha1) {
+            sha1_to_string(record->sha1, sha1_string);
+        }
+        fprintf(file, "%s %08x %s %i %c %i %i\n",
+            record->known ? "rom" : "seen",
+            record->crc32,
+            record->has_sha1 ? sha1_string : "-",
+            record->mapper,
+            MIRRORING_LETTERS[record->mirroring],
+            record->prg_ram_length / PRG_RAM_UNIT,
+            record->battery
+        );
+    }
+    fprintf(file, "# file <size> <mtime seconds> <mtime nanoseconds> <crc32> <sha1> <path>\n");
+    for (int i = 0; i < file_count; i++) {
+        FileRecord *record = &files[i];
+        sha1_to_string(record->sha1, sha1_string);
+        fprintf(file, "file %lli %lli %li %08x %s %s\n",
+            record->size,
+            record->mtime_seconds,
+            record->mtime_nanoseconds,
+            record->crc32,
+            sha1_string,
+            record->path
+        );
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    bool written = !ferror(file);
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporary_path, file_path) != 0) {
+        fprintf(stderr, "Couldn't write ROM database '%s'.\n", file_path);
+        remove(temporary_path);
+        return false;
+    }
+    return true;
+}
+
+// Releases every cached ROM, the records are kept
+// ROMs still running elsewhere stay loaded until their last owner releases them
+void rom_cache_clear(void) {
+    pthread_mutex_lock(&cache_lock);
+    for (int i = 0; i < rom_count; i++) {
+        if (roms[i].rom != NULL) {
+            free_rom(roms[i].rom);
+            roms[i].rom = NULL;
+        }
+    }
+    for (int i = 0; i < file_count; i++) {
+        if (files[i].rom != NULL) {
+            free_rom(files[i].rom);
+            files[i].rom = NULL;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
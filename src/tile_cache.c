@@ -0,0 +1,105 @@
+#include "../lib/tile_cache.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Bit of each bitplane byte that holds each pixel, left to right
+static const uint8_t PIXEL_BITS[32] = {
+    0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+    0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+    0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+    0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+};
+static const uint8_t FLIPPED_PIXEL_BITS[32] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+};
+
+// Marks every tile as needing to be decoded
+void tile_cache_init(TileCache *cache) {
+    memset(cache->dirty, true, sizeof(cache->dirty));
+}
+
+// Invalidates the tiles overlapping 'length' bytes of pattern memory from 'addr'
+// Called on CHR RAM writes and CHR bank switches
+void tile_cache_invalidate(TileCache *cache, uint16_t addr, int length) {
+    int first = addr / TILE_BYTES;
+    int last = (addr + length - 1) / TILE_BYTES;
+    for (int tile = first; tile <= last && tile < CACHED_TILES; tile++) {
+        cache->dirty[tile] = true;
+    }
+}
+
+// Decodes both variants of one tile from its 16 bytes at 'data'
+void tile_cache_decode(TileCache *cache, const uint8_t *data, int tile) {
+    tile_decode(data, cache->pixels[tile], false);
+    tile_decode(data, cache->flipped[tile], true);
+    cache->dirty[tile] = false;
+}
+
+// Expands the two bitplanes of a tile into one byte per pixel
+// Every bitplane byte is broadcast across 8 lanes, which are tested against one bit each
+void tile_decode(const uint8_t *tile, uint8_t *pixels, bool flipped) {
+    const uint8_t *bits = flipped ? FLIPPED_PIXEL_BITS : PIXEL_BITS;
+#if defined(__AVX2__)
+    __m256i mask = _mm256_loadu_si256((const __m256i *) bits);
+    for (int row = 0; row < TILE_SIZE; row += 4) {
+        __m256i low = _mm256_set_epi64x(
+            0x0101010101010101ULL * tile[row + 3],
+            0x0101010101010101ULL * tile[row + 2],
+            0x0101010101010101ULL * tile[row + 1],
+            0x0101010101010101ULL * tile[row]
+        );
+        __m256i high = _mm256_set_epi64x(
+            0x0101010101010101ULL * tile[row + TILE_SIZE + 3],
+            0x0101010101010101ULL * tile[row + TILE_SIZE + 2],
+            0x0101010101010101ULL * tile[row + TILE_SIZE + 1],
+            0x0101010101010101ULL * tile[row + TILE_SIZE]
+        );
+        low = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(low, mask), mask), _mm256_set1_epi8(1));
+        high = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(high, mask), mask), _mm256_set1_epi8(2));
+        _mm256_storeu_si256((__m256i *) (pixels + row * TILE_SIZE), _mm256_or_si256(low, high));
+    }
+#elif defined(__SSE2__)
+    __m128i mask = _mm_loadu_si128((const __m128i *) bits);
+    for (int row = 0; row < TILE_SIZE; row += 2) {
+        __m128i low = _mm_set_epi64x(
+            0x0101010101010101ULL * tile[row + 1],
+            0x0101010101010101ULL * tile[row]
+        );
+        __m128i high = _mm_set_epi64x(
+            0x0101010101010101ULL * tile[row + TILE_SIZE + 1],
+            0x0101010101010101ULL * tile[row + TILE_SIZE]
+        );
+        low = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(low, mask), mask), _mm_set1_epi8(1));
+        high = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(high, mask), mask), _mm_set1_epi8(2));
+        _mm_storeu_si128((__m128i *) (pixels + row * TILE_SIZE), _mm_or_si128(low, high));
+    }
+#elif defined(__ARM_NEON)
+    uint8x16_t mask = vld1q_u8(bits);
+    for (int row = 0; row < TILE_SIZE; row += 2) {
+        uint8x16_t low = vcombine_u8(vdup_n_u8(tile[row]), vdup_n_u8(tile[row + 1]));
+        uint8x16_t high = vcombine_u8(vdup_n_u8(tile[row + TILE_SIZE]), vdup_n_u8(tile[row + TILE_SIZE + 1]));
+        low = vandq_u8(vtstq_u8(low, mask), vdupq_n_u8(1));
+        high = vandq_u8(vtstq_u8(high, mask), vdupq_n_u8(2));
+        vst1q_u8(pixels + row * TILE_SIZE, vorrq_u8(low, high));
+    }
+#else
+    for (int row = 0; row < TILE_SIZE; row++) {
+        uint8_t low = tile[row];
+        uint8_t high = tile[row + TILE_SIZE];
+        for (int x = 0; x < TILE_SIZE; x++) {
+            pixels[row * TILE_SIZE + x] = ((low & bits[x]) ? 1 : 0) | ((high & bits[x]) ? 2 : 0);
+        }
+    }
+#endif
+}
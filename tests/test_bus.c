@@ -0,0 +1,151 @@
+#include "test_framework.h"
+#include "../lib/cpu.h"
+#include "../lib/bus.h"
+#include "../lib/ppu.h"
+#include "../lib/renderer.h"
+#include "../lib/io.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_oam_dma_even_cycle(void);
+void test_oam_dma_odd_cycle(void);
+void test_interrupt_cycles(void);
+void test_sprite_zero_hit_dot(void);
+void test_sprite_zero_hit_after_write(void);
+
+int successful_tests = 0;
+int failed_tests = 0;
+
+int main(int argc, char **argv) {
+    test_oam_dma_even_cycle();
+    test_oam_dma_odd_cycle();
+    test_interrupt_cycles();
+    test_sprite_zero_hit_dot();
+    test_sprite_zero_hit_after_write();
+    end_tests();
+}
+
+// Powers on a console running 'program' from $8000
+CPU *new_test_cpu(uint8_t *program, int length) {
+    static uint8_t frame[FRAME_SIZE];
+    ROM *rom = new_test_rom(0, 0x8000, 0x2000);
+    for (int i = 0; i < length; i++) {
+        rom->prg_rom[i] = program[i];
+    }
+    rom->prg_rom[0x7FFD] = 0x80; // Reset vector
+    CPU *cpu = new_cpu(rom);
+    cpu->bus->ppu->frame = frame;
+    reset(cpu);
+    return cpu;
+}
+
+// Runs one instruction the way run_frame() does, returns the cycles it took
+int step(CPU *cpu) {
+    uint64_t cycles_before = cpu->bus->cycles;
+    interpret(cpu, mem_read(cpu, cpu->program_counter));
+    int cycles = cpu->bus->cycles - cycles_before;
+    bus_tick(cpu->bus, cycles);
+    return cycles;
+}
+
+void test_oam_dma_even_cycle(void) {
+    uint8_t program[] = {
+        0xA9, 0x02,       // LDA #$02 (2 cycles)
+        0x8D, 0x14, 0x40, // STA $4014 (4 cycles), DMA starts on cycle 6
+    };
+    CPU *cpu = new_test_cpu(program, sizeof(program));
+    assert_eq(step(cpu), 2);
+    assert_eq(step(cpu), 4 + OAM_DMA_CYCLES);
+    assert_eq(cpu->bus->cycles, 6 + OAM_DMA_CYCLES);
+    destroy_cpu(cpu);
+}
+
+void test_oam_dma_odd_cycle(void) {
+    uint8_t program[] = {
+        0xA5, 0x00,       // LDA $00 (3 cycles)
+        0x8D, 0x14, 0x40, // STA $4014 (4 cycles), DMA starts on cycle 7
+        0x8D, 0x14, 0x40, // STA $4014 (4 cycles), DMA starts on cycle 7 + 518 + 4
+    };
+    CPU *cpu = new_test_cpu(program, sizeof(program));
+    assert_eq(step(cpu), 3);
+    assert_eq(step(cpu), 4 + OAM_DMA_CYCLES + 1);
+    assert_eq(step(cpu), 4 + OAM_DMA_CYCLES + 1);
+    assert_eq(cpu->bus->cycles, 3 + 2 * (4 + OAM_DMA_CYCLES + 1));
+    destroy_cpu(cpu);
+}
+
+// Interrupts are counted once, like instructions
+void test_interrupt_cycles(void) {
+    uint8_t program[] = {0xEA}; // NOP
+    CPU *cpu = new_test_cpu(program, sizeof(program));
+    assert_eq(step(cpu), 2);
+    interrupt(cpu, NMI);
+    assert_eq(cpu->bus->cycles, 2 + 7);
+    destroy_cpu(cpu);
+}
+
+// Fills the screen with opaque background tiles and puts sprite 0, solid as well, at 'x' on 'scanline'
+CPU *new_sprite_zero_cpu(int x, int scanline) {
+    uint8_t program[] = {0xEA}; // NOP
+    CPU *cpu = new_test_cpu(program, sizeof(program));
+    PPU *ppu = cpu->bus->ppu;
+    for (int row = 0; row < TILE_SIZE; row++) {
+        ppu->chr_banks[0][TILE_BYTES + row] = 0xFF;
+    }
+    memset(ppu->vram, 1, ATTRIBUTE_TABLE_OFFSET);
+    uint8_t sprite[] = {scanline - 1, 1, 0, x};
+    mem_write(cpu, 0, 0x2003);
+    for (int i = 0; i < SPRITE_BYTES; i++) {
+        mem_write(cpu, sprite[i], 0x2004);
+    }
+    return cpu;
+}
+
+// Runs the PPU up to 'dot', as close as whole CPU cycles get
+void tick_to_dot(CPU *cpu, int dot) {
+    while (cpu->bus->ppu->dot + 3 <= dot) {
+        bus_tick(cpu->bus, 1);
+    }
+}
+
+// The hit shows up on the dot its pixel comes out, long before the scanline is drawn
+void test_sprite_zero_hit_dot(void) {
+    CPU *cpu = new_sprite_zero_cpu(100, 30);
+    PPU *ppu = cpu->bus->ppu;
+    mem_write(cpu, SHOW_BACKGROUND | SHOW_SPRITES | SHOW_BACKGROUND_LEFT | SHOW_SPRITES_LEFT, 0x2001);
+    int hit_dot = 30 * SCANLINE_CYCLES + 100 + 1;
+
+    tick_to_dot(cpu, hit_dot - 1);
+    assert_eq(mem_read(cpu, 0x2002) & SPRITE_ZERO_HIT, 0);
+    // The PPU syncs by itself on the dot of the hit
+    bus_tick(cpu->bus, 1);
+    assert_eq(ppu->status & SPRITE_ZERO_HIT, SPRITE_ZERO_HIT);
+    assert_eq(ppu->drawn_scanlines, 30);
+
+    // Cleared on the pre-render scanline, then hit again on the next frame
+    tick_to_dot(cpu, PRE_RENDER_DOT + 3);
+    assert_eq(ppu->status & SPRITE_ZERO_HIT, 0);
+    tick_to_dot(cpu, FRAME_DOTS - 1);
+    bus_tick(cpu->bus, 1);
+    assert_eq(ppu->status & SPRITE_ZERO_HIT, 0);
+    tick_to_dot(cpu, hit_dot + 3);
+    assert_eq(ppu->status & SPRITE_ZERO_HIT, SPRITE_ZERO_HIT);
+    destroy_cpu(cpu);
+}
+
+// Pixels that came out before rendering was turned on don't hit
+void test_sprite_zero_hit_after_write(void) {
+    CPU *cpu = new_sprite_zero_cpu(100, 30);
+    PPU *ppu = cpu->bus->ppu;
+    tick_to_dot(cpu, 30 * SCANLINE_CYCLES + 150);
+    mem_write(cpu, SHOW_BACKGROUND | SHOW_SPRITES | SHOW_BACKGROUND_LEFT | SHOW_SPRITES_LEFT, 0x2001);
+
+    tick_to_dot(cpu, 31 * SCANLINE_CYCLES);
+    assert_eq(mem_read(cpu, 0x2002) & SPRITE_ZERO_HIT, 0);
+    // Sprite 0 still covers the next scanline
+    tick_to_dot(cpu, 31 * SCANLINE_CYCLES + 100 + 1 + 3);
+    assert_eq(ppu->status & SPRITE_ZERO_HIT, SPRITE_ZERO_HIT);
+    destroy_cpu(cpu);
+}
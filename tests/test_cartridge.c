@@ -0,0 +1,265 @@
+#include "test_framework.h"
+#include "../lib/cartridge.h"
+#include "../lib/rom_cache.h"
+#include "../lib/checksum.h"
+#include "../lib/mapper.h"
+#include "../lib/nes.h"
+#include "../lib/bus.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+void test_get_rom_maps_file(void);
+void test_rom_references(void);
+void test_short_file(void);
+void test_cache_shares_content(void);
+void test_cache_clear(void);
+void test_database_corrects_header(void);
+void test_ines_defaults(void);
+void test_nes2_header(void);
+void test_nes_load_cart_memory(void);
+
+int successful_tests = 0;
+int failed_tests = 0;
+
+int main(int argc, char **argv) {
+    test_get_rom_maps_file();
+    test_rom_references();
+    test_short_file();
+    test_cache_shares_content();
+    test_cache_clear();
+    test_database_corrects_header();
+    test_ines_defaults();
+    test_nes2_header();
+    test_nes_load_cart_memory();
+    rom_cache_clear();
+    end_tests();
+}
+
+// Writes a '.nes' file holding 'header' and 'length' bytes counting up from 'first' after it
+// Returns its path, which the caller frees after unlinking the file
+char *write_test_file(const uint8_t *header, int length, uint8_t first) {
+    char *path = strdup("/tmp/test_cartridge_XXXXXX.nes");
+    int file = mkstemps(path, strlen(".nes"));
+    FILE *stream = fdopen(file, "wb");
+    fwrite(header, 1, HEADER_LENGTH, stream);
+    for (int i = 0; i < length; i++) {
+        fputc((uint8_t) (first + i), stream);
+    }
+    fclose(stream);
+    return path;
+}
+
+void remove_test_file(char *path) {
+    unlink(path);
+    free(path);
+}
+
+void test_get_rom_maps_file(void) {
+    uint8_t header[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1, 0x01};
+    char *path = write_test_file(header, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 1);
+    ROM *rom = get_rom(path);
+    assert_eq(rom != NULL, true);
+    // PRG and CHR point into the mapping, right after the header
+    assert_eq(rom->prg_rom, rom->image + HEADER_LENGTH);
+    assert_eq(rom->chr_rom, rom->prg_rom + PRG_ROM_PAGE_SIZE);
+    assert_eq(rom->prg_rom_length, PRG_ROM_PAGE_SIZE);
+    assert_eq(rom->chr_rom_length, CHR_ROM_PAGE_SIZE);
+    assert_eq(rom->prg_rom[0], 1);
+    assert_eq(rom->chr_rom[0], (uint8_t) (1 + PRG_ROM_PAGE_SIZE));
+    assert_eq(rom->mapper, 0);
+    assert_eq(rom->mirroring, Vertical);
+    free_rom(rom);
+    remove_test_file(path);
+}
+
+void test_rom_references(void) {
+    ROM *rom = new_test_rom(0, PRG_ROM_PAGE_SIZE, CHR_ROM_PAGE_SIZE);
+    assert_eq(atomic_load(&rom->shares), 0);
+    assert_eq(rom_retain(rom), rom);
+    assert_eq(atomic_load(&rom->shares), 1);
+    // The first release leaves it to the other owner
+    free_rom(rom);
+    assert_eq(atomic_load(&rom->shares), 0);
+    free_rom(rom);
+}
+
+void test_short_file(void) {
+    // Two PRG pages are promised, one is there
+    uint8_t header[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 2, 1};
+    char *path = write_test_file(header, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 2);
+    assert_eq(get_rom(path) == NULL, true);
+    remove_test_file(path);
+}
+
+void test_cache_shares_content(void) {
+    uint8_t header[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1};
+    char *path = write_test_file(header, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 3);
+    char *copy = write_test_file(header, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 3);
+    ROM *rom = get_rom(path);
+    // Loaded again, or from another file with the same PRG, CHR and header
+    ROM *again = get_rom(path);
+    ROM *copy_rom = get_rom(copy);
+    assert_eq(again, rom);
+    assert_eq(copy_rom, rom);
+
+    // A different header isn't shared
+    uint8_t vertical[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1, 0x01};
+    char *other = write_test_file(vertical, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 3);
+    ROM *other_rom = get_rom(other);
+    assert_eq(other_rom != rom, true);
+    assert_eq(other_rom->mirroring, Vertical);
+
+    free_rom(rom);
+    free_rom(again);
+    free_rom(copy_rom);
+    free_rom(other_rom);
+    remove_test_file(path);
+    remove_test_file(copy);
+    remove_test_file(other);
+}
+
+void test_cache_clear(void) {
+    uint8_t header[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1};
+    char *path = write_test_file(header, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 4);
+    ROM *rom = get_rom(path);
+    // The cache holds one reference for the content and one for the file
+    assert_eq(atomic_load(&rom->shares), 2);
+    rom_cache_clear();
+    assert_eq(atomic_load(&rom->shares), 0);
+    free_rom(rom);
+    remove_test_file(path);
+}
+
+void test_database_corrects_header(void) {
+    // The header says NROM without PRG RAM battery, the database says MMC1 with 8 kB kept by a battery
+    uint8_t header[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1, 0x01};
+    int length = PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE;
+    char *path = write_test_file(header, length, 5);
+    uint8_t *content = malloc(length);
+    for (int i = 0; i < length; i++) {
+        content[i] = 5 + i;
+    }
+    char *database = strdup("/tmp/test_database_XXXXXX");
+    FILE *stream = fdopen(mkstemp(database), "w");
+    fprintf(stream, "# Test database\nrom %08x - 1 H 8 1\n", crc32_bytes(content, length));
+    fclose(stream);
+    free(content);
+
+    assert_eq(rom_cache_load_database(database), true);
+    ROM *rom = get_rom(path);
+    assert_eq(rom->verified, true);
+    assert_eq(rom->mapper, 1);
+    assert_eq(rom->mirroring, Horizontal);
+    assert_eq(rom->battery, true);
+    assert_eq(rom->prg_ram_length, 0);
+    assert_eq(rom->prg_nvram_length, 8192);
+    free_rom(rom);
+
+    // Records are written back with the SHA-1 the file filled in
+    assert_eq(rom_cache_save_database(database), true);
+    char line[ROM_DATABASE_LINE_LENGTH];
+    bool found = false;
+    stream = fopen(database, "r");
+    while (fgets(line, sizeof(line), stream) != NULL) {
+        found |= strncmp(line, "rom ", 4) == 0 && strstr(line, " - ") == NULL;
+    }
+    fclose(stream);
+    assert_eq(found, true);
+
+    unlink(database);
+    free(database);
+    remove_test_file(path);
+}
+
+void test_ines_defaults(void) {
+    // No PRG RAM size means 8 kB, the battery keeps it, no CHR ROM means 8 kB of CHR RAM
+    uint8_t header[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 0, 0x02};
+    char *path = write_test_file(header, PRG_ROM_PAGE_SIZE, 6);
+    ROM *rom = get_rom(path);
+    assert_eq(rom->nes2, false);
+    assert_eq(rom->prg_ram_length, 0);
+    assert_eq(rom->prg_nvram_length, 8192);
+    assert_eq(rom->chr_rom == NULL, true);
+    assert_eq(rom->chr_ram_length, CHR_RAM_DEFAULT_SIZE);
+    assert_eq(rom->timing, NTSC);
+    assert_eq(mapper_memory_size(rom), 8192 + CHR_RAM_DEFAULT_SIZE);
+    free_rom(rom);
+    remove_test_file(path);
+
+    // Sizes are in units of 8 kB, without a battery it's all volatile
+    uint8_t sized[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1, 0x00, 0x00, 2};
+    path = write_test_file(sized, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 7);
+    rom = get_rom(path);
+    assert_eq(rom->prg_ram_length, 16384);
+    assert_eq(rom->prg_nvram_length, 0);
+    assert_eq(rom->chr_ram_length, 0);
+    assert_eq(mapper_memory_size(rom), 16384);
+    free_rom(rom);
+    remove_test_file(path);
+}
+
+void test_nes2_header(void) {
+    uint8_t header[HEADER_LENGTH] = {
+        'N', 'E', 'S', 0x1A, 2, 0,
+        0x40, // Mapper 4, low nibble
+        0x08, // NES 2.0
+        0x10, // Submapper 1
+        0x00,
+        0x97, // 32 kB of PRG NVRAM, 8 kB of PRG RAM
+        0x07, // 8 kB of CHR RAM
+        0x01, // PAL
+    };
+    char *path = write_test_file(header, 2 * PRG_ROM_PAGE_SIZE, 8);
+    ROM *rom = get_rom(path);
+    assert_eq(rom->nes2, true);
+    assert_eq(rom->mapper, 4);
+    assert_eq(rom->submapper, 1);
+    assert_eq(rom->prg_rom_length, 2 * PRG_ROM_PAGE_SIZE);
+    assert_eq(rom->prg_ram_length, 8192);
+    assert_eq(rom->prg_nvram_length, 32768);
+    assert_eq(rom->chr_ram_length, 8192);
+    assert_eq(rom->chr_nvram_length, 0);
+    assert_eq(rom->timing, PAL);
+    assert_eq(mapper_memory_size(rom), 8192 + 32768 + 8192);
+    free_rom(rom);
+    remove_test_file(path);
+
+    // Exponent-multiplier sizes, 2^13 * 3 bytes of PRG ROM
+    uint8_t exponent[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 13 << 2 | 1, 0, 0x00, 0x08, 0x00, 0x0F};
+    path = write_test_file(exponent, 3 * 8192, 9);
+    rom = get_rom(path);
+    assert_eq(rom->prg_rom_length, 3 * 8192);
+    assert_eq(rom->prg_ram_length, 0);
+    assert_eq(mapper_memory_size(rom), CHR_RAM_DEFAULT_SIZE);
+    free_rom(rom);
+    remove_test_file(path);
+
+    // The mapper number has 12 bits
+    uint8_t wide_mapper[HEADER_LENGTH] = {'N', 'E', 'S', 0x1A, 1, 1, 0x40, 0x08, 0x01};
+    path = write_test_file(wide_mapper, PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 10);
+    assert_eq(get_rom(path) == NULL, true); // Mapper 260 isn't supported
+    remove_test_file(path);
+}
+
+// Consoles keep the cart RAM they were built with
+void test_nes_load_cart_memory(void) {
+    ROM *small = new_test_rom(0, PRG_ROM_PAGE_SIZE, CHR_ROM_PAGE_SIZE);
+    ROM *big = new_test_rom(0, PRG_ROM_PAGE_SIZE, CHR_ROM_PAGE_SIZE);
+    big->prg_ram_length = 0x8000;
+    NES *nes = nes_new(rom_retain(small));
+    assert_eq(nes->bus->mapper.memory_size, mapper_memory_size(small));
+
+    assert_eq(nes_load(nes, big), false);
+    assert_eq(nes->rom, small);
+    assert_eq(nes->bus->mapper.prg_ram_length, 0x2000);
+    assert_eq(nes_load(nes, small), true);
+    assert_eq(nes->rom, small);
+
+    free_rom(big);
+    nes_destroy(nes);
+    free_rom(small);
+}
@@ -0,0 +1,66 @@
+#include "test_framework.h"
+#include "../lib/checksum.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_crc32(void);
+void test_sha1(void);
+void test_sha1_strings(void);
+
+int successful_tests = 0;
+int failed_tests = 0;
+
+int main(int argc, char **argv) {
+    test_crc32();
+    test_sha1();
+    test_sha1_strings();
+    end_tests();
+}
+
+// Returns true if 'bytes' hash to the hex digest 'expected'
+bool sha1_is(const char *bytes, size_t length, const char *expected) {
+    uint8_t digest[SHA1_LENGTH];
+    char string[SHA1_STRING_LENGTH];
+    sha1_bytes((const uint8_t *) bytes, length, digest);
+    sha1_to_string(digest, string);
+    return strcmp(string, expected) == 0;
+}
+
+void test_crc32(void) {
+    assert_eq(crc32_bytes((const uint8_t *) "", 0), 0x00000000);
+    assert_eq(crc32_bytes((const uint8_t *) "123456789", 9), 0xCBF43926);
+    assert_eq(crc32_bytes((const uint8_t *) "The quick brown fox jumps over the lazy dog", 43), 0x414FA339);
+}
+
+void test_sha1(void) {
+    assert_eq(sha1_is("", 0, "da39a3ee5e6b4b0d3255bfef95601890afd80709"), true);
+    assert_eq(sha1_is("abc", 3, "a9993e364706816aba3e25717850c26c9cd0d89d"), true);
+    // Spans two blocks
+    const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    assert_eq(sha1_is(two_blocks, strlen(two_blocks), "84983e441c3bd26ebaae4aa1f95129e5e54670f1"), true);
+    // The padding only fits in a block of its own
+    char block[64];
+    memset(block, 'a', sizeof(block));
+    assert_eq(sha1_is(block, 56, "c2db330f6083854c99d4b5bfb6e8f29f201be699"), true);
+
+    char *million = malloc(1000000);
+    memset(million, 'a', 1000000);
+    assert_eq(sha1_is(million, 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f"), true);
+    free(million);
+}
+
+void test_sha1_strings(void) {
+    uint8_t digest[SHA1_LENGTH];
+    char string[SHA1_STRING_LENGTH];
+    assert_eq(sha1_from_string("A9993E364706816ABA3E25717850C26C9CD0D89D", digest), true);
+    assert_eq(digest[0], 0xA9);
+    assert_eq(digest[SHA1_LENGTH - 1], 0x9D);
+    sha1_to_string(digest, string);
+    assert_eq(strcmp(string, "a9993e364706816aba3e25717850c26c9cd0d89d"), 0);
+
+    assert_eq(sha1_from_string("a9993e36", digest), false);
+    assert_eq(sha1_from_string("a9993e364706816aba3e25717850c26c9cd0d89d00", digest), false);
+    assert_eq(sha1_from_string("g9993e364706816aba3e25717850c26c9cd0d89d", digest), false);
+}
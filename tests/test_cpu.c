@@ -1,6 +1,8 @@
 #include "test_framework.h"
 #include "../lib/cpu.h"
 #include "../lib/instructions.h"
+#include "../lib/bus.h"
+#include "../lib/cartridge.h"
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -32,109 +34,122 @@ int main(int argc, char **argv) {
     end_tests();
 }
 
+// Powers on a console with 'program' at $8000, reset() jumps to it
+CPU *new_test_cpu(uint8_t *program, int length) {
+    ROM *rom = new_test_rom(0, 0x8000, 0x2000);
+    for (int i = 0; i < length; i++) {
+        rom->prg_rom[i] = program[i];
+    }
+    rom->prg_rom[0x7FFD] = 0x80; // Reset vector
+    return new_cpu(rom);
+}
+
 void test_new(void) {
-    CPU *cpu = new_cpu();
-    assert_eq(cpu->status, 0);
+    CPU *cpu = new_test_cpu(NULL, 0);
+    assert_eq(get_status(cpu), 0);
     assert_eq(cpu->reg_a, 0);
     assert_eq(cpu->reg_x, 0);
     assert_eq(cpu->reg_y, 0);
     assert_eq(cpu->program_counter, 0);
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_read_and_mem_write(void) {
-    CPU *cpu = new_cpu();
-    mem_write(cpu, 0xAB, 0x8000);
-    assert_eq(cpu->memory[0x8000], 0xAB);
-    assert_eq(mem_read(cpu, 0x8000), 0xAB);
+    CPU *cpu = new_test_cpu(NULL, 0);
+    mem_write(cpu, 0xAB, 0x0200);
+    assert_eq(cpu->bus->ram[0x0200], 0xAB);
+    assert_eq(mem_read(cpu, 0x0200), 0xAB);
+    assert_eq(mem_read(cpu, 0x0A00), 0xAB); // RAM is mirrored every 2KB
     
     // 16 bit tests
-    mem_write_u16(cpu, 0xABCD, 0x8000);
-    assert_eq(cpu->memory[0x8000], 0xCD);
-    assert_eq(cpu->memory[0x8000 + 1], 0xAB);
-    assert_eq(mem_read_u16(cpu, 0x8000), 0xABCD);
-    free(cpu);
+    mem_write_u16(cpu, 0xABCD, 0x0200);
+    assert_eq(cpu->bus->ram[0x0200], 0xCD);
+    assert_eq(cpu->bus->ram[0x0200 + 1], 0xAB);
+    assert_eq(mem_read_u16(cpu, 0x0200), 0xABCD);
+    destroy_cpu(cpu);
 }
 
 void test_reset(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     cpu->reg_a = 10;
     cpu->reg_x = 25;
     cpu->reg_y = 50;
-    cpu->status = 64;
-    mem_write_u16(cpu, 0xABCD, 0xFFFC);
+    set_status(cpu, 64);
+    cpu->bus->rom->prg_rom[0x7FFC] = 0xCD;
+    cpu->bus->rom->prg_rom[0x7FFD] = 0xAB;
     reset(cpu);
-    assert_eq(cpu->status, 0b00100100);
+    assert_eq(get_status(cpu), 0b00100100);
     assert_eq(cpu->reg_a, 0);
     assert_eq(cpu->reg_x, 0);
     assert_eq(cpu->reg_y, 0);
     assert_eq(cpu->program_counter, 0xABCD);
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_load(void) {
-    CPU *cpu = new_cpu();
     uint8_t program[3] = { 0xAB, 0xCD, 0xDE };
-    load(cpu, program, 3);
+    CPU *cpu = new_test_cpu(program, 3);
+    load(cpu);
 
     uint8_t program_start_lsb = PROGRAM_START & 0xFF;
     uint8_t program_start_msb = PROGRAM_START >> 8;
     
-    assert_eq(cpu->memory[0xFFFC], program_start_lsb);
-    assert_eq(cpu->memory[0xFFFD], program_start_msb);
-    assert_eq(cpu->memory[PROGRAM_START], 0xAB);
-    assert_eq(cpu->memory[PROGRAM_START + 1], 0xCD);
-    assert_eq(cpu->memory[PROGRAM_START + 2], 0xDE);
-    free(cpu);
+    assert_eq(mem_read(cpu, 0xFFFC), program_start_lsb);
+    assert_eq(mem_read(cpu, 0xFFFD), program_start_msb);
+    assert_eq(cpu->program_counter, PROGRAM_START);
+    assert_eq(mem_read(cpu, 0x8000), 0xAB);
+    assert_eq(mem_read(cpu, 0x8001), 0xCD);
+    assert_eq(mem_read(cpu, 0x8002), 0xDE);
+    destroy_cpu(cpu);
 }
 
 void test_run(void) {
-    CPU *cpu = new_cpu();
-    populate_inst_list();
-    
     uint8_t program[] = { 0xA9, 0xC0, 0xAA, 0xE8, 0x00 };
     int program_length = sizeof(program) / sizeof(program[0]);
-    load(cpu, program, program_length);
-    run_for_testing(cpu);
+    CPU *cpu = new_test_cpu(program, program_length);
+    reset(cpu);
+    while (mem_read(cpu, cpu->program_counter) != 0x00) {
+        interpret(cpu, mem_read(cpu, cpu->program_counter));
+    }
 
     assert_eq(cpu->reg_a, 0xC0);
     assert_eq(cpu->reg_x, 0xC1);
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_set_unset_flag(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     set_flag(cpu, NEGATIVE_FLAG);
 
-    assert_eq(cpu->status, 0b10000000);
+    assert_eq(get_status(cpu), 0b10000000);
 
     set_flag(cpu, CARRY_FLAG);
-    assert_eq(cpu->status, 0b10000001);
+    assert_eq(get_status(cpu), 0b10000001);
 
     unset_flag(cpu, NEGATIVE_FLAG);
-    assert_eq(cpu->status, 0b00000001);
-    free(cpu);
+    assert_eq(get_status(cpu), 0b00000001);
+    destroy_cpu(cpu);
 }
 
 void test_is_set(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     set_flag(cpu, NEGATIVE_FLAG);
     assert_eq(is_set(cpu, NEGATIVE_FLAG), true);
     assert_eq(is_set(cpu, ZERO_FLAG), false);
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_get_stack_addr(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     cpu->stack_pointer = 0xAA;
     assert_eq(get_stack_addr(cpu), 0x01AA);
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_stack(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     cpu->stack_pointer = 0xFF;
     stack_push_u16(cpu, 0xAABB);
     assert_eq(stack_pull_u16(cpu), 0xAABB);
-    free(cpu);
+    destroy_cpu(cpu);
 }
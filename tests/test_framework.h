@@ -2,11 +2,13 @@
 #define TEST_FRAMEWORK_H
 
 #include "../lib/cpu.h"
+#include "../lib/cartridge.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define assert_eq(actual, expected) \
-    if (actual == expected) { successful_tests++; } \
+    if ((actual) == (expected)) { successful_tests++; } \
     else { printf("%s failed at %s at line %i.\n", __FUNCTION__,  __FILE__, __LINE__); failed_tests++; }
 
 #define end_tests() printf("Testing over:\nSucceeded: %i\nFailed: %i\n", successful_tests, failed_tests);
@@ -22,4 +24,19 @@ void run_for_testing(CPU *cpu) {
     }
 }
 
+// Builds a cartridge in memory, with zeroed PRG ROM and CHR ROM
+// 'chr_rom_length' 0 gives the default amount of CHR RAM instead
+ROM *new_test_rom(int mapper, int prg_rom_length, int chr_rom_length) {
+    ROM *rom = calloc(1, sizeof(ROM));
+    rom->mapper = mapper;
+    rom->mirroring = Horizontal;
+    rom->prg_rom_length = prg_rom_length;
+    rom->prg_rom = calloc(1, prg_rom_length);
+    rom->chr_rom_length = chr_rom_length;
+    rom->chr_rom = chr_rom_length ? calloc(1, chr_rom_length) : NULL;
+    rom->chr_ram_length = chr_rom_length ? 0 : CHR_RAM_DEFAULT_SIZE;
+    rom->prg_ram_length = 0x2000;
+    return rom;
+}
+
 #endif
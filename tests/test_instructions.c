@@ -1,16 +1,17 @@
 #include "test_framework.h"
 #include "../lib/instructions.h"
 #include "../lib/cpu.h"
+#include "../lib/cartridge.h"
 
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 int successful_tests = 0;
 int failed_tests = 0;
 
-void test_get_instruction_from_opcode(void);
-void test_populate_inst_list(void);
+void test_opcode_table(void);
 void test_update_zero_and_negative_flags(void);
 void test_get_operand_addr(void);
 void test_instructions(void);
@@ -19,8 +20,7 @@ void test_inc_instructions(void);
 void test_loops(void);
 
 int main(int argc, char **argv) {
-    test_get_instruction_from_opcode();
-    test_populate_inst_list();
+    test_opcode_table();
     test_update_zero_and_negative_flags();
     test_get_operand_addr();
     test_instructions();
@@ -30,53 +30,60 @@ int main(int argc, char **argv) {
     end_tests();
 }
 
-void test_get_instruction_from_opcode(void) {
-    Instruction inst = get_instruction_from_opcode(0xA9);
-    assert_eq(inst.opcode, 0xA9);
-    assert_eq(inst.bytes, 2);
+// Powers on a console with 'program' at $8000, reset() jumps to it
+CPU *new_test_cpu(uint8_t *program, int length) {
+    ROM *rom = new_test_rom(0, 0x8000, 0x2000);
+    for (int i = 0; i < length; i++) {
+        rom->prg_rom[i] = program[i];
+    }
+    rom->prg_rom[0x7FFD] = 0x80; // Reset vector
+    return new_cpu(rom);
 }
 
-void test_populate_inst_list(void) {
-    populate_inst_list();
-    Instruction brk = inst_list[0x00];
-    assert_eq(brk.opcode, 0x00);
-    Instruction lda = inst_list[0xA9];
-    assert_eq(lda.opcode, 0xA9);
+void test_opcode_table(void) {
+    OpcodeInfo lda = OPCODE_TABLE[0xA9];
+    assert_eq(lda.bytes, 2);
+    assert_eq(lda.cycles, 2);
     assert_eq(lda.mode, Immediate);
+    assert_eq(strcmp(OPCODE_MNEMONICS[0xA9], "LDA"), 0);
+
+    OpcodeInfo lda_absolute_x = OPCODE_TABLE[0xBD];
+    assert_eq(lda_absolute_x.mode, AbsoluteX);
+    assert_eq(strcmp(OPCODE_MNEMONICS[0xA7], "*LAX"), 0);
 }
 
 void test_update_zero_and_negative_flags(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     update_zero_and_negative_flags(cpu, 0);
-    assert_eq(cpu->status, 0b00000010);
+    assert_eq(get_status(cpu), 0b00000010);
     update_zero_and_negative_flags(cpu, 0b10110010);
-    assert_eq(cpu->status, 0b10000000);
+    assert_eq(get_status(cpu), 0b10000000);
     update_zero_and_negative_flags(cpu, 0b00101101);
-    assert_eq(cpu->status, 0b00000000);
-    free(cpu);
+    assert_eq(get_status(cpu), 0b00000000);
+    destroy_cpu(cpu);
 }
 
 void test_get_operand_addr(void) {
-    CPU *cpu = new_cpu();
+    CPU *cpu = new_test_cpu(NULL, 0);
     cpu->program_counter = 15;
-    assert_eq(get_operand_addr(cpu, Immediate), 15);
+    assert_eq(get_operand_addr(cpu, Immediate, false), 15);
     
     // Zero page
     cpu->reg_x = 5;
     cpu->reg_y = 10;
     mem_write(cpu, 0xAB, cpu->program_counter);
-    assert_eq(get_operand_addr(cpu, ZeroPage), 0xAB);
-    assert_eq(get_operand_addr(cpu, ZeroPageX), 0xAB + 5);
-    assert_eq(get_operand_addr(cpu, ZeroPageY), 0xAB + 10);
+    assert_eq(get_operand_addr(cpu, ZeroPage, false), 0xAB);
+    assert_eq(get_operand_addr(cpu, ZeroPageX, false), 0xAB + 5);
+    assert_eq(get_operand_addr(cpu, ZeroPageY, false), 0xAB + 10);
 
     // Absolute
     cpu->program_counter = 100;
     cpu->reg_x = 50;
     cpu->reg_y = 25;
     mem_write_u16(cpu, 0xBABA, cpu->program_counter);
-    assert_eq(get_operand_addr(cpu, Absolute), 0xBABA);
-    assert_eq(get_operand_addr(cpu, AbsoluteX), 0xBABA + 50);
-    assert_eq(get_operand_addr(cpu, AbsoluteY), 0xBABA + 25);
+    assert_eq(get_operand_addr(cpu, Absolute, false), 0xBABA);
+    assert_eq(get_operand_addr(cpu, AbsoluteX, false), 0xBABA + 50);
+    assert_eq(get_operand_addr(cpu, AbsoluteY, false), 0xBABA + 25);
 
     // Indirect
     cpu->program_counter = 200;
@@ -85,58 +92,54 @@ void test_get_operand_addr(void) {
 
     mem_write_u16(cpu, 0x0120, cpu->program_counter);
     mem_write_u16(cpu, 0xBAFC, 0x0120);
-    assert_eq(get_operand_addr(cpu, Indirect), 0xBAFC);
+    assert_eq(get_operand_addr(cpu, Indirect, false), 0xBAFC);
 
     cpu->program_counter = 300;
     mem_write(cpu, 0xBC, cpu->program_counter);
-    mem_write_u16(cpu, 0xABBA, 0xBC + cpu->reg_x);
-    assert_eq(get_operand_addr(cpu, IndirectX), 0xABBA);
+    // The pointer wraps around inside the zero page
+    mem_write_u16(cpu, 0xABBA, (uint8_t) (0xBC + cpu->reg_x));
+    assert_eq(get_operand_addr(cpu, IndirectX, false), 0xABBA);
 
     mem_write_u16(cpu, 0xBAAB, 0xBC);
-    assert_eq(get_operand_addr(cpu, IndirectY), 0xBAAB + cpu->reg_y);
-    free(cpu);
+    assert_eq(get_operand_addr(cpu, IndirectY, false), 0xBAAB + cpu->reg_y);
+    destroy_cpu(cpu);
 }
 
 void test_instructions(void) {
-    CPU *cpu = new_cpu();
-    populate_inst_list();
+    CPU *cpu = new_test_cpu(NULL, 0);
 
     cpu->reg_a = 0x80;
     mem_write(cpu, 0x80, 0);
     adc(cpu, Immediate);
-    assert_eq(cpu->status, CARRY_FLAG | OVERFLOW_FLAG);
-    free(cpu);
+    assert_eq(get_status(cpu), CARRY_FLAG | OVERFLOW_FLAG | ZERO_FLAG);
+    destroy_cpu(cpu);
 }
 
 // Tests the add with carry function and its instructions
 void test_add_with_carry(void) {
     // Initialization
-    CPU *cpu = new_cpu();
-    populate_inst_list();
+    CPU *cpu = new_test_cpu(NULL, 0);
     
     // Makes ADC operation that should overflow
     set_reg_a(cpu, 150);
-    add_with_carry(cpu, 150, true);
+    add_with_carry(cpu, 150);
     assert_eq(is_set(cpu, OVERFLOW_FLAG), true);
     assert_eq(is_set(cpu, CARRY_FLAG), true);
 
     // Cleanup
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_inc_instructions(void) {
-    CPU *cpu = new_cpu();
-    reset(cpu);
+    CPU *cpu = new_test_cpu(NULL, 0);
     mem_write(cpu, 0x10, cpu->program_counter);
     inc(cpu, Immediate);
     assert_eq(mem_read(cpu, cpu->program_counter), 0x11);
 
-    free(cpu);
+    destroy_cpu(cpu);
 }
 
 void test_loops(void) {
-    CPU *cpu = new_cpu();
-    populate_inst_list();
     uint8_t program[] = {
         0xa2, 0x00, 0xa0, 0x00, 0x8a, 0x99, 0x00, 0x02, 0x48, 0xe8, 0xc8, 0xc0, 0x10, 0xd0, 0xf5, 0x68,
         0x99, 0x00, 0x02, 0xc8, 0xc0, 0x20, 0xd0, 0xf7
@@ -144,10 +147,12 @@ void test_loops(void) {
 
     int program_length = sizeof(program)/sizeof(program[0]);
     
-    load(cpu, program, program_length);
+    CPU *cpu = new_test_cpu(program, program_length);
     reset(cpu);
-    run_for_testing(cpu);
+    for (int i = 0; i < 1000 && cpu->program_counter < 0x8000 + program_length; i++) {
+        interpret(cpu, mem_read(cpu, cpu->program_counter));
+    }
     assert_eq(cpu->reg_y, 0x20);
 
-    free(cpu);
+    destroy_cpu(cpu);
 }
@@ -12,9 +12,9 @@
 #define LINE_LENGTH 75
 #define CPU_REGS_POSITION 48
 
-void write_line_string(char *line_string, CPU *cpu, Instruction inst);
+void write_line_string(char *line_string, CPU *cpu, uint8_t opcode);
 void run_and_log(CPU *cpu);
-void enter_log(CPU *cpu, FILE *file, Instruction inst);
+void enter_log(CPU *cpu, FILE *file, uint8_t opcode);
 
 int main(int argc, char **argv) {
     ROM *rom = get_rom(NES_TEST_PATH);
@@ -22,7 +22,6 @@ int main(int argc, char **argv) {
         return 1;
     }
     CPU *cpu = new_cpu(rom);
-    populate_inst_list();
     reset(cpu);
     cpu->program_counter = 0xC000;
 
@@ -32,7 +31,10 @@ int main(int argc, char **argv) {
     return 0;
 }
 
-void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
+void write_line_string(char *line_string, CPU *cpu, uint8_t opcode) {
+    OpcodeInfo inst = OPCODE_TABLE[opcode];
+    const char *mnemonic = OPCODE_MNEMONICS[opcode];
+
     // Pointer to keep track of the last character
     int last_char_position = 0;
 
@@ -49,7 +51,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%02X %02X %02X  ",
-                inst.opcode,
+                opcode,
                 mem_read(cpu, cpu->program_counter + 1),
                 mem_read(cpu, cpu->program_counter + 2)
             );
@@ -59,7 +61,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%02X %02X     ",
-                inst.opcode,
+                opcode,
                 mem_read(cpu, cpu->program_counter + 1)
             );
             break;
@@ -68,7 +70,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%02X        ",
-                inst.opcode
+                opcode
             );
             break;
     }
@@ -76,13 +78,13 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
     // Handles the assembly opcode
     // Must increment the program counter and decrement it later for this to work properly
     cpu->program_counter++;
-    uint16_t addr = get_operand_addr(cpu, inst.mode);
+    uint16_t addr = get_operand_addr(cpu, inst.mode, false);
     cpu->program_counter--;
 
     uint8_t operand;
 
     // Creates space for unofficial opcodes' * character
-    if (strlen(inst.mnemonic) == 4) {
+    if (strlen(mnemonic) == 4) {
         last_char_position--;
     }
 
@@ -91,7 +93,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s #$%02X",
-                inst.mnemonic,
+                mnemonic,
                 mem_read(cpu, addr)
             );
             break;
@@ -100,7 +102,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s $%02X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 addr,
                 mem_read(cpu, addr)
             );
@@ -110,7 +112,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s $%02X,X @ %02X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 mem_read(cpu, cpu->program_counter + 1),
                 addr,
                 mem_read(cpu, addr)
@@ -121,7 +123,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s $%02X,Y @ %02X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 mem_read(cpu, cpu->program_counter + 1),
                 addr,
                 mem_read(cpu, addr)
@@ -129,11 +131,11 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             break;
 
         case Absolute:
-            if (inst.opcode == 0x4C || inst.opcode == 0x20) {
+            if (opcode == 0x4C || opcode == 0x20) {
                 last_char_position += sprintf(
                     line_string + last_char_position,
                     "%s $%04X",
-                    inst.mnemonic,
+                    mnemonic,
                     addr
                 );
             }
@@ -141,7 +143,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
                 last_char_position += sprintf(
                     line_string + last_char_position,
                     "%s $%04X = %02X",
-                    inst.mnemonic,
+                    mnemonic,
                     addr,
                     mem_read(cpu, addr)
                 );
@@ -152,7 +154,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s $%04X,X @ %04X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 mem_read_u16(cpu, cpu->program_counter + 1),
                 addr,
                 mem_read(cpu, addr)
@@ -163,7 +165,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s $%04X,Y @ %04X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 mem_read_u16(cpu, cpu->program_counter + 1),
                 addr,
                 mem_read(cpu, addr)
@@ -174,7 +176,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s ($%04X) = %04X",
-                inst.mnemonic,
+                mnemonic,
                 mem_read_u16(cpu, cpu->program_counter + 1),
                 addr
             );
@@ -185,7 +187,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s ($%02X,X) @ %02X = %04X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 operand,
                 (uint8_t) (operand + cpu->reg_x),
                 addr,
@@ -202,7 +204,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s ($%02X),Y = %04X @ %04X = %02X",
-                inst.mnemonic,
+                mnemonic,
                 operand,
                 resulting_addr,
                 addr,
@@ -211,7 +213,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             break;
 
         case Implied:
-            switch (inst.opcode) {
+            switch (opcode) {
                 // Handles accumulator instructions
                 case 0x0A:
                 case 0x4A:
@@ -220,7 +222,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
                     last_char_position += sprintf(
                         line_string + last_char_position,
                         "%s A",
-                        inst.mnemonic
+                        mnemonic
                     );
                     break;
                 
@@ -228,7 +230,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
                     last_char_position += sprintf(
                         line_string + last_char_position,
                         "%s",
-                        inst.mnemonic
+                        mnemonic
                     );
                     break;
             }
@@ -238,7 +240,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
             last_char_position += sprintf(
                 line_string + last_char_position,
                 "%s $%04X",
-                inst.mnemonic,
+                mnemonic,
                 cpu->program_counter + 2 + (int8_t) mem_read(cpu, cpu->program_counter + 1)
             );
             break;
@@ -257,7 +259,7 @@ void write_line_string(char *line_string, CPU *cpu, Instruction inst) {
         cpu->reg_a,
         cpu->reg_x,
         cpu->reg_y,
-        cpu->status,
+        get_status(cpu),
         cpu->stack_pointer
     );
 
@@ -278,9 +280,7 @@ void run_and_log(CPU *cpu) {
 
     while (1) {
         uint8_t opcode = mem_read(cpu, cpu->program_counter);
-        Instruction inst = inst_list[opcode];
-        
-        enter_log(cpu, file, inst);
+        enter_log(cpu, file, opcode);
         interpret(cpu, opcode);
         if (opcode == 0x00) {
             printf("Breaking at %X\n", cpu->program_counter);
@@ -291,8 +291,8 @@ void run_and_log(CPU *cpu) {
     fclose(file);
 }
 
-void enter_log(CPU *cpu, FILE *file, Instruction inst) {
+void enter_log(CPU *cpu, FILE *file, uint8_t opcode) {
     char string_to_write[LINE_LENGTH];
-    write_line_string(string_to_write, cpu, inst);
+    write_line_string(string_to_write, cpu, opcode);
     fwrite(string_to_write, strlen(string_to_write) * sizeof(char), 1, file);
 }
@@ -0,0 +1,209 @@
+#include "test_framework.h"
+#include "../lib/cpu.h"
+#include "../lib/bus.h"
+#include "../lib/ppu.h"
+#include "../lib/mapper.h"
+#include "../lib/cartridge.h"
+#include "../lib/io.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+void test_mmc1_shift_register(void);
+void test_mmc1_prg_modes(void);
+void test_mmc1_chr_banks(void);
+void test_mmc3_banks(void);
+void test_mmc3_irq_counter(void);
+void test_mmc3_irq_scanlines(void);
+
+int successful_tests = 0;
+int failed_tests = 0;
+
+int main(int argc, char **argv) {
+    test_mmc1_shift_register();
+    test_mmc1_prg_modes();
+    test_mmc1_chr_banks();
+    test_mmc3_banks();
+    test_mmc3_irq_counter();
+    test_mmc3_irq_scanlines();
+    end_tests();
+}
+
+// Builds a console whose PRG banks of 'prg_bank_size' and CHR banks of 'chr_bank_size' start with their number
+CPU *new_banked_cpu(int mapper, int prg_rom_length, int prg_bank_size, int chr_rom_length, int chr_bank_size) {
+    static uint8_t frame[FRAME_SIZE];
+    ROM *rom = new_test_rom(mapper, prg_rom_length, chr_rom_length);
+    for (int bank = 0; bank < prg_rom_length / prg_bank_size; bank++) {
+        rom->prg_rom[bank * prg_bank_size] = bank;
+    }
+    for (int bank = 0; bank < chr_rom_length / chr_bank_size; bank++) {
+        rom->chr_rom[bank * chr_bank_size] = bank;
+    }
+    CPU *cpu = new_cpu(rom);
+    cpu->bus->ppu->frame = frame;
+    return cpu;
+}
+
+// Loads an MMC1 register through the shift register, low bit first
+void mmc1_load(CPU *cpu, uint16_t addr, uint8_t value) {
+    for (int i = 0; i < 5; i++) {
+        mem_write(cpu, (value >> i) & 1, addr);
+    }
+}
+
+uint8_t chr_bank_at(CPU *cpu, uint16_t addr) {
+    return cpu->bus->ppu->chr_banks[addr / CHR_BANK_SIZE][0];
+}
+
+void test_mmc1_shift_register(void) {
+    CPU *cpu = new_banked_cpu(1, 0x20000, PRG_BANK_16K, 0x2000, 0x1000);
+    // Powers up with the last bank fixed at $C000
+    assert_eq(mem_read(cpu, 0x8000), 0);
+    assert_eq(mem_read(cpu, 0xC000), 7);
+
+    // Nothing changes until the fifth write
+    for (int i = 0; i < 4; i++) {
+        mem_write(cpu, 1, 0xE000);
+    }
+    assert_eq(mem_read(cpu, 0x8000), 0);
+    mem_write(cpu, 0, 0xE000);
+    // Bank 15 wraps around to bank 7
+    assert_eq(mem_read(cpu, 0x8000), 7);
+
+    // Bit 7 throws away the bits written so far
+    mem_write(cpu, 1, 0xE000);
+    mem_write(cpu, 1, 0xE000);
+    mem_write(cpu, 0x80, 0xE000);
+    mmc1_load(cpu, 0xE000, 2);
+    assert_eq(mem_read(cpu, 0x8000), 2);
+    assert_eq(mem_read(cpu, 0xC000), 7);
+    destroy_cpu(cpu);
+}
+
+void test_mmc1_prg_modes(void) {
+    CPU *cpu = new_banked_cpu(1, 0x20000, PRG_BANK_16K, 0x2000, 0x1000);
+    mmc1_load(cpu, 0xE000, 5);
+
+    // First bank fixed at $8000
+    mmc1_load(cpu, 0x8000, 0x08);
+    assert_eq(mem_read(cpu, 0x8000), 0);
+    assert_eq(mem_read(cpu, 0xC000), 5);
+
+    // 32 kB at a time, ignoring the low bit
+    mmc1_load(cpu, 0x8000, 0x00);
+    assert_eq(mem_read(cpu, 0x8000), 4);
+    assert_eq(mem_read(cpu, 0xC000), 5);
+    destroy_cpu(cpu);
+}
+
+void test_mmc1_chr_banks(void) {
+    CPU *cpu = new_banked_cpu(1, 0x8000, PRG_BANK_16K, 0x8000, 0x1000);
+
+    // Two 4 kB banks
+    mmc1_load(cpu, 0x8000, 0x1C);
+    mmc1_load(cpu, 0xA000, 3);
+    mmc1_load(cpu, 0xC000, 6);
+    assert_eq(chr_bank_at(cpu, 0x0000), 3);
+    assert_eq(chr_bank_at(cpu, 0x1000), 6);
+
+    // 8 kB at a time, ignoring the low bit of the first register
+    mmc1_load(cpu, 0x8000, 0x0C);
+    assert_eq(chr_bank_at(cpu, 0x0000), 2);
+    assert_eq(chr_bank_at(cpu, 0x1000), 3);
+    destroy_cpu(cpu);
+}
+
+void test_mmc3_banks(void) {
+    CPU *cpu = new_banked_cpu(4, 0x10000, PRG_BANK_8K, 0x8000, CHR_BANK_SIZE);
+    // R6 at $8000, R7 at $A000, the second last and last banks at $C000 and $E000
+    mem_write(cpu, 6, 0x8000);
+    mem_write(cpu, 3, 0x8001);
+    mem_write(cpu, 7, 0x8000);
+    mem_write(cpu, 4, 0x8001);
+    assert_eq(mem_read(cpu, 0x8000), 3);
+    assert_eq(mem_read(cpu, 0xA000), 4);
+    assert_eq(mem_read(cpu, 0xC000), 6);
+    assert_eq(mem_read(cpu, 0xE000), 7);
+
+    // Bit 6 swaps $8000 and $C000
+    mem_write(cpu, 0x40, 0x8000);
+    assert_eq(mem_read(cpu, 0x8000), 6);
+    assert_eq(mem_read(cpu, 0xC000), 3);
+
+    // R0 is a 2 kB bank at $0000, ignoring its low bit, R2 a 1 kB bank at $1000
+    mem_write(cpu, 0, 0x8000);
+    mem_write(cpu, 9, 0x8001);
+    mem_write(cpu, 2, 0x8000);
+    mem_write(cpu, 20, 0x8001);
+    assert_eq(chr_bank_at(cpu, 0x0000), 8);
+    assert_eq(chr_bank_at(cpu, 0x0400), 9);
+    assert_eq(chr_bank_at(cpu, 0x1000), 20);
+
+    // Bit 7 swaps the pattern table halves
+    mem_write(cpu, 0x80, 0x8000);
+    assert_eq(chr_bank_at(cpu, 0x1000), 8);
+    assert_eq(chr_bank_at(cpu, 0x0000), 20);
+    destroy_cpu(cpu);
+}
+
+void test_mmc3_irq_counter(void) {
+    CPU *cpu = new_banked_cpu(4, 0x10000, PRG_BANK_8K, 0x8000, CHR_BANK_SIZE);
+    Mapper *mapper = &cpu->bus->mapper;
+    mem_write(cpu, 2, 0xC000); // Latch
+    mem_write(cpu, 0, 0xC001); // Reload
+    assert_eq(mapper->a12_clocks_until_irq(mapper), 0); // Disabled
+    mem_write(cpu, 0, 0xE001); // Enable
+    assert_eq(mapper->a12_clocks_until_irq(mapper), 3);
+
+    // Reloads to 2 on the first edge, raises the IRQ when it gets down to 0
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->state.mmc3.irq_counter, 2);
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->irq, false);
+    assert_eq(mapper->a12_clocks_until_irq(mapper), 1);
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->irq, true);
+    assert_eq(mapper->a12_clocks_until_irq(mapper), 0); // Already pending
+
+    // Held until acknowledged, disabling acknowledges
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->state.mmc3.irq_counter, 2);
+    mem_write(cpu, 0, 0xE000);
+    assert_eq(mapper->irq, false);
+    mapper->a12_clock(mapper);
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->irq, false);
+
+    // Latch 0 raises it on every edge
+    mem_write(cpu, 0, 0xC000);
+    mem_write(cpu, 0, 0xC001);
+    mem_write(cpu, 0, 0xE001);
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->irq, true);
+    mem_write(cpu, 0, 0xE000);
+    mem_write(cpu, 0, 0xE001);
+    mapper->a12_clock(mapper);
+    assert_eq(mapper->irq, true);
+    destroy_cpu(cpu);
+}
+
+// The counter is clocked once per rendered scanline when sprites use the $1000 pattern table
+void test_mmc3_irq_scanlines(void) {
+    CPU *cpu = new_banked_cpu(4, 0x10000, PRG_BANK_8K, 0x8000, CHR_BANK_SIZE);
+    PPU *ppu = cpu->bus->ppu;
+    mem_write(cpu, 3, 0xC000);
+    mem_write(cpu, 0, 0xC001);
+    mem_write(cpu, 0, 0xE001);
+    mem_write(cpu, 0x08, 0x2000); // Sprites at $1000
+    mem_write(cpu, 0x18, 0x2001); // Rendering on
+
+    // Edges at dot 260 of scanlines 0-3, the PPU only catches up when it predicted the IRQ
+    for (int scanline = 0; scanline < 3; scanline++) {
+        ppu_tick(ppu, SCANLINE_CYCLES);
+    }
+    assert_eq(cpu->bus->mapper.irq, false);
+    ppu_tick(ppu, SCANLINE_CYCLES);
+    assert_eq(cpu->bus->mapper.irq, true);
+    assert_eq(bus_poll_for_interrupt(cpu->bus), IRQ);
+    destroy_cpu(cpu);
+}